@@ -0,0 +1,146 @@
+#include "alloc_profiler.h"
+#include <algorithm>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+
+bool alloc_profiling = false;
+
+thread_local const Node* AllocSiteScope::current = nullptr;
+
+namespace {
+
+struct TypeStats {
+    size_t allocations = 0;
+    size_t bytes = 0;
+    size_t live = 0;
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+};
+
+struct SiteKey {
+    const std::type_info* type;
+    uint32_t line;
+    uint32_t column;
+
+    bool operator<(const SiteKey& other) const {
+        return std::tie(type, line, column) < std::tie(other.type, other.line, other.column);
+    }
+};
+
+struct SiteStats {
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+struct LiveBlock {
+    const std::type_info* type;
+    size_t bytes;
+};
+
+struct Profile {
+    std::mutex mutex;
+    std::map<const std::type_info*, TypeStats> types;
+    std::map<SiteKey, SiteStats> sites;
+    std::unordered_map<const void*, LiveBlock> live;
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+};
+
+// Nunca se destruye: hay objetos que se liberan después de main
+Profile& profile() {
+    static Profile* instance = new Profile();
+    return *instance;
+}
+
+std::string type_name(const std::type_info& type) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : type.name();
+    std::free(demangled);
+    return name;
+}
+
+std::string site_name(uint32_t line, uint32_t column) {
+    if (line == 0) return "?";
+    return std::to_string(line) + ":" + std::to_string(column);
+}
+
+} // namespace
+
+void enable_alloc_profiling() {
+    profile();
+    alloc_profiling = true;
+}
+
+void record_allocation(const void* address, const std::type_info& type, size_t bytes) {
+    const Node* site = AllocSiteScope::site();
+    record_allocation_at(address, type, bytes, site ? site->line : 0, site ? site->column : 0);
+}
+
+void record_allocation_at(const void* address, const std::type_info& type, size_t bytes,
+                          uint32_t line, uint32_t column) {
+    Profile& p = profile();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    TypeStats& stats = p.types[&type];
+    ++stats.allocations;
+    stats.bytes += bytes;
+    ++stats.live;
+    stats.live_bytes += bytes;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+
+    SiteStats& site = p.sites[SiteKey{&type, line, column}];
+    ++site.allocations;
+    site.bytes += bytes;
+
+    p.live[address] = LiveBlock{&type, bytes};
+    p.live_bytes += bytes;
+    p.peak_bytes = std::max(p.peak_bytes, p.live_bytes);
+}
+
+void record_release(const void* address) {
+    Profile& p = profile();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    auto it = p.live.find(address);
+    // Creado antes de prender el perfil o por fuera de los puntos anotados
+    if (it == p.live.end()) return;
+    TypeStats& stats = p.types[it->second.type];
+    --stats.live;
+    stats.live_bytes -= it->second.bytes;
+    p.live_bytes -= it->second.bytes;
+    p.live.erase(it);
+}
+
+void report_alloc_profile(std::ostream& out, size_t top_sites) {
+    Profile& p = profile();
+    std::lock_guard<std::mutex> lock(p.mutex);
+
+    out << "# alloc profile: vivos " << p.live_bytes << " bytes, pico " << p.peak_bytes << " bytes\n";
+    out << "# tipo allocs bytes vivos bytes_vivos pico_bytes\n";
+    // Primero los tipos que más memoria pidieron
+    std::vector<std::pair<const std::type_info*, TypeStats>> types(p.types.begin(), p.types.end());
+    std::sort(types.begin(), types.end(), [](const auto& a, const auto& b) { return a.second.bytes > b.second.bytes; });
+    for (const auto& [type, stats] : types) {
+        out << "# " << type_name(*type) << " " << stats.allocations << " " << stats.bytes << " "
+            << stats.live << " " << stats.live_bytes << " " << stats.peak_bytes << "\n";
+    }
+
+    std::vector<std::pair<SiteKey, SiteStats>> sites(p.sites.begin(), p.sites.end());
+    size_t shown = std::min(top_sites, sites.size());
+    std::partial_sort(sites.begin(), sites.begin() + shown, sites.end(), [](const auto& a, const auto& b) {
+        return a.second.allocations > b.second.allocations;
+    });
+    out << "# sitios (línea:columna tipo allocs bytes)\n";
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& [key, stats] = sites[i];
+        out << "#   " << site_name(key.line, key.column) << " " << type_name(*key.type) << " "
+            << stats.allocations << " " << stats.bytes << "\n";
+    }
+}
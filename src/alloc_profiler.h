@@ -0,0 +1,70 @@
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <typeinfo>
+
+class Node;
+
+// Perfil de memoria (--alloc-profile): cada objeto del runtime, entorno y
+// nodo del AST se anota con su tipo, su tamaño y el lugar del script que lo
+// creó. Los nodos del AST llevan su propia posición; los valores del runtime
+// toman la del nodo que se está evaluando en ese hilo (ver AllocSiteScope).
+// Apagado, el costo es leer un bool en cada constructor y destructor.
+//
+// Los bytes son los del objeto (sizeof), sin el bloque de control del
+// shared_ptr ni las tablas de los entornos.
+
+// Se prende una sola vez al arrancar, antes de crear hilos
+extern bool alloc_profiling;
+
+void enable_alloc_profiling();
+
+void record_allocation(const void* address, const std::type_info& type, size_t bytes);
+void record_allocation_at(const void* address, const std::type_info& type, size_t bytes,
+                          uint32_t line, uint32_t column);
+void record_release(const void* address);
+
+inline void profile_allocation(const void* address, const std::type_info& type, size_t bytes) {
+    if (alloc_profiling) record_allocation(address, type, bytes);
+}
+
+inline void profile_allocation_at(const void* address, const std::type_info& type, size_t bytes,
+                                  uint32_t line, uint32_t column) {
+    if (alloc_profiling) record_allocation_at(address, type, bytes, line, column);
+}
+
+inline void profile_release(const void* address) {
+    if (alloc_profiling) record_release(address);
+}
+
+// Nodo del script al que se atribuyen las asignaciones del hilo actual
+class AllocSiteScope {
+public:
+    explicit AllocSiteScope(const Node* node) : active(alloc_profiling) {
+        if (active) {
+            saved = current;
+            current = node;
+        }
+    }
+    ~AllocSiteScope() {
+        if (active) current = saved;
+    }
+
+    AllocSiteScope(const AllocSiteScope&) = delete;
+    AllocSiteScope& operator=(const AllocSiteScope&) = delete;
+
+    static const Node* site() { return current; }
+
+private:
+    static thread_local const Node* current;
+    bool active;
+    const Node* saved = nullptr;
+};
+
+// Tabla por tipo (cantidad, bytes, vivos y pico) y los sitios que más asignan
+void report_alloc_profile(std::ostream& out, size_t top_sites = 10);
+
+#endif // ALLOC_PROFILER_H
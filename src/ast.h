@@ -4,21 +4,53 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include "tokens.h"
+#include "alloc_profiler.h"
+
+// Papel de un nodo en la numeración de valores (ver value_numbering.h)
+enum class ValueRole : unsigned char {
+    NONE,
+    DEFINE,       // primera aparición: guarda su valor
+    REUSE,        // repetición: usa el valor guardado
+    LAST_REUSE,   // última repetición: se lo lleva
+};
 
 class Node {
 public:
-    virtual ~Node() = default;
+    virtual ~Node() { profile_release(this); }
     virtual std::string token_literal() const = 0;
     virtual std::string to_string() const = 0;
+
+    // Posición de su token en el fuente (la pone el parser; 0 si no se conoce)
+    uint32_t line = 0;
+    uint32_t column = 0;
+
+    ValueRole value_role = ValueRole::NONE;
+    uint8_t value_slot = 0;
 };
 
 class Statement : public Node {
 };
 
+// Tipos estáticos como conjunto de bits: una unión es un OR (ver type_inference.h)
+namespace static_types {
+constexpr unsigned char NONE = 0;
+constexpr unsigned char INTEGER = 1;
+constexpr unsigned char BOOLEAN = 2;
+constexpr unsigned char FUNCTION = 4;
+constexpr unsigned char NULL_VALUE = 8;
+constexpr unsigned char TASK = 16;
+constexpr unsigned char STRING = 32;
+constexpr unsigned char ANY = INTEGER | BOOLEAN | FUNCTION | NULL_VALUE | TASK | STRING;
+}
+
 class Expression : public Node {
 public:
     virtual Token get_token() const = 0;
+    // Si la expresión da un valor, es de uno de estos tipos (puede dar
+    // nullptr por un error). ANY hasta que la inferencia diga otra cosa.
+    unsigned char static_type = static_types::ANY;
 };
 
 class Program : public Node {
@@ -81,10 +113,25 @@ public:
     }
 };
 
+// Cuerpo de función que el parser solo recorrió para balancear llaves (ver
+// Parser::lazy_function_bodies). Guarda el texto de sus tokens en sus líneas
+// y columnas originales; parse_lazy_body arma el AST en la primera llamada.
+struct LazyBody {
+    std::string source;
+    uint32_t line = 1;   // línea del primer token
+    std::once_flag parsed;
+    bool failed = false;
+};
+
 class BlockStatement : public Statement {
 public:
     Token token;
     std::vector<std::unique_ptr<Statement>> statements;
+    // Solo para cuerpos de función: false si el marco de la llamada no puede
+    // ser capturado por una clausura (ver escape_analysis.h)
+    bool frame_escapes = true;
+    // No nulo si statements todavía puede estar sin parsear
+    std::unique_ptr<LazyBody> lazy;
 
 
     BlockStatement(const Token& tok) : token(tok) {}
@@ -94,6 +141,7 @@ public:
     }
 
     std::string to_string() const override {
+        if (lazy && statements.empty()) return "{ " + lazy->source + " }";
         std::string result = "{ ";
         for (const auto& stmt : statements) {
             result += stmt->to_string() + " ";
@@ -124,6 +172,29 @@ public:
     }
 };
 
+// La cadena se crea (y se interna) al parsear: cada evaluación devuelve el
+// mismo objeto, que es inmutable
+class StringLiteral : public Expression {
+public:
+    Token token;
+    std::shared_ptr<class String> value;
+
+    Token get_token() const override {
+        return token;
+    }
+
+    StringLiteral(const Token& tok, std::shared_ptr<class String> val)
+        : token(tok), value(std::move(val)) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return token.literal;
+    }
+};
+
 class BooleanLiteral : public Expression {
 public:
     Token token;
@@ -172,6 +243,10 @@ public:
     Token token;
     std::vector<std::string> parameters;
     std::shared_ptr<BlockStatement> body;
+    // Clausura convertida (ver closure_conversion.h): captura solo las
+    // variables de captures en lugar del entorno entero
+    bool converted = false;
+    std::vector<std::string> captures;
 
     Token get_token() const override {
         return token;
@@ -225,6 +300,20 @@ public:
     }
 };
 
+// Llamada a una función chica que se evalúa en línea (ver inlining.h): si
+// en ejecución la función llamada tiene este cuerpo, se calcula value con
+// los argumentos sin crear el marco; si no, es una llamada común. Para el
+// resto de los recorridos es un CallExpression más.
+class InlinedCall : public CallExpression {
+public:
+    std::shared_ptr<BlockStatement> body;   // lo mantiene vivo aunque se libere el let
+    Expression* value;                      // la única expresión de body
+
+    InlinedCall(const Token& tok, std::unique_ptr<Expression> func, std::shared_ptr<BlockStatement> bod,
+                Expression* val)
+        : CallExpression(tok, std::move(func)), body(std::move(bod)), value(val) {}
+};
+
 class ExpressionStatement : public Statement {
 public:
     Token token;
@@ -286,6 +375,111 @@ public:
     }
 };
 
+// Forma reconocida de un for contado (ver induction.h):
+//     for (let i = inicio; i < limite; i = i + paso) { ... }
+// con < > o != como comparación, un paso literal (la actualización también
+// puede ser un let) y un límite literal o una variable que el cuerpo no
+// vuelve a ligar.
+struct CountedLoop {
+    bool valid = false;
+    std::string var;
+    std::string cmp;
+    int step = 0;
+    Expression* limit = nullptr;   // dentro de la condición del for
+};
+
+class ForStatement : public Statement {
+public:
+    Token token;
+    std::unique_ptr<Statement> init;         // cualquiera de las tres partes puede faltar
+    std::unique_ptr<Expression> condition;
+    std::unique_ptr<Statement> update;
+    std::unique_ptr<BlockStatement> body;
+    CountedLoop counted;
+
+    ForStatement(const Token& tok) : token(tok) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return "for (" + (init ? init->to_string() : ";") + " " + (condition ? condition->to_string() : "") + "; " +
+               (update ? update->to_string() : "") + ") " + (body ? body->to_string() : "");
+    }
+};
+
+// x = valor: actualiza una ligadura existente (ver Environment::assign)
+class AssignExpression : public Expression {
+public:
+    Token token;
+    std::string name;
+    std::unique_ptr<Expression> value;
+
+    Token get_token() const override {
+        return token;
+    }
+
+    AssignExpression(const Token& tok, const std::string& nm, std::unique_ptr<Expression> val)
+        : token(tok), name(nm), value(std::move(val)) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return "(" + name + " = " + (value ? value->to_string() : "") + ")";
+    }
+};
+
+class ReturnStatement : public Statement {
+public:
+    Token token;
+    std::unique_ptr<Expression> value;   // nullptr en un return sin valor
+
+    ReturnStatement(const Token& tok, std::unique_ptr<Expression> val)
+        : token(tok), value(std::move(val)) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return token_literal() + (value ? " " + value->to_string() : "") + ";";
+    }
+};
+
+// break y continue: solo se distinguen por el token
+class BreakStatement : public Statement {
+public:
+    Token token;
+
+    BreakStatement(const Token& tok) : token(tok) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return token_literal() + ";";
+    }
+};
+
+class ContinueStatement : public Statement {
+public:
+    Token token;
+
+    ContinueStatement(const Token& tok) : token(tok) {}
+
+    std::string token_literal() const override {
+        return token.literal;
+    }
+
+    std::string to_string() const override {
+        return token_literal() + ";";
+    }
+};
+
 class InfixExpression : public Expression {
 public:
     Token token;
@@ -0,0 +1,397 @@
+#include "batch.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include "environment.h"
+#include "evaluator.h"
+#include "inlining.h"
+#include "type_inference.h"
+
+namespace {
+
+using Op = BatchProgram::Op;
+using Instr = BatchProgram::Instr;
+
+struct Register {
+    int index = 0;
+    ObjectType type = ObjectType::INTEGER_OBJ;
+};
+
+// Expresión de una rama de if de una sola expresión, o nullptr
+Expression* branch_value(const BlockStatement* block) {
+    if (!block || block->statements.size() != 1) return nullptr;
+    auto expr_stmt = dynamic_cast<ExpressionStatement*>(block->statements[0].get());
+    return expr_stmt ? expr_stmt->expression.get() : nullptr;
+}
+
+class BatchCompiler {
+public:
+    explicit BatchCompiler(const BatchProgram::Inputs& inputs) : registers(inputs.size()) {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            names[inputs[i].first] = Register{static_cast<int>(i), inputs[i].second};
+        }
+    }
+
+    // result queda en el registro con el valor de la última sentencia
+    bool compile(const Program& program, Register& result) {
+        if (program.statements.empty()) return false;
+        for (const auto& stmt : program.statements) {
+            if (auto let_stmt = dynamic_cast<LetStatement*>(stmt.get())) {
+                if (!expression(let_stmt->value.get(), result)) return false;
+                names[let_stmt->name] = result;
+            } else if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(stmt.get())) {
+                if (!expression(expr_stmt->expression.get(), result)) return false;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Instr> code;
+    size_t registers;
+
+private:
+    // Entradas y let compilados hasta ahora
+    std::unordered_map<std::string, Register> names;
+
+    Register emit(Op op, ObjectType type, int a = 0, int b = 0) {
+        Register out{static_cast<int>(registers++), type};
+        code.push_back({op, out.index, a, b});
+        return out;
+    }
+
+    bool expression(Expression* node, Register& out) {
+        if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+            out = emit(Op::CONST, ObjectType::INTEGER_OBJ, int_lit->value);
+            return true;
+        }
+
+        if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
+            out = emit(Op::CONST, ObjectType::BOOLEAN_OBJ, bool_lit->value);
+            return true;
+        }
+
+        if (auto ident = dynamic_cast<Identifier*>(node)) {
+            auto it = names.find(ident->value);
+            if (it == names.end()) return false;
+            out = it->second;
+            return true;
+        }
+
+        if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+            Register right;
+            if (!expression(prefix->right.get(), right)) return false;
+            if (prefix->op == "-" && right.type == ObjectType::INTEGER_OBJ) {
+                out = emit(Op::NEG, ObjectType::INTEGER_OBJ, right.index);
+                return true;
+            }
+            if (prefix->op == "!" && right.type == ObjectType::BOOLEAN_OBJ) {
+                out = emit(Op::NOT, ObjectType::BOOLEAN_OBJ, right.index);
+                return true;
+            }
+            return false;
+        }
+
+        if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+            Register left, right;
+            if (!expression(infix->left.get(), left) || !expression(infix->right.get(), right)) return false;
+            if (left.type != right.type) return false;
+
+            const std::string& op = infix->op;
+            if (op == "==" || op == "!=") {
+                out = emit(op == "==" ? Op::EQ : Op::NE, ObjectType::BOOLEAN_OBJ, left.index, right.index);
+                return true;
+            }
+            if (left.type != ObjectType::INTEGER_OBJ) return false;
+            if (op == "<" || op == ">") {
+                out = emit(op == "<" ? Op::LT : Op::GT, ObjectType::BOOLEAN_OBJ, left.index, right.index);
+                return true;
+            }
+            Op arithmetic;
+            if (op == "+") arithmetic = Op::ADD;
+            else if (op == "-") arithmetic = Op::SUB;
+            else if (op == "*") arithmetic = Op::MUL;
+            else if (op == "/") arithmetic = Op::DIV;
+            else return false;
+            out = emit(arithmetic, ObjectType::INTEGER_OBJ, left.index, right.index);
+            return true;
+        }
+
+        if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
+            // Cada rama corre solo en sus filas y deja su valor en el mismo registro
+            Register condition, then_value, else_value;
+            Expression* consequence = branch_value(if_expr->consequence.get());
+            Expression* alternative = branch_value(if_expr->alternative.get());
+            if (!consequence || !alternative) return false;
+            if (!expression(if_expr->condition.get(), condition) || condition.type != ObjectType::BOOLEAN_OBJ) {
+                return false;
+            }
+            int merged = static_cast<int>(registers++);
+            code.push_back({Op::SELECT, 0, condition.index, 0});
+            if (!expression(consequence, then_value)) return false;
+            code.push_back({Op::MOVE, merged, then_value.index, 0});
+            code.push_back({Op::SELECT_ELSE, 0, 0, 0});
+            if (!expression(alternative, else_value) || else_value.type != then_value.type) return false;
+            code.push_back({Op::MOVE, merged, else_value.index, 0});
+            code.push_back({Op::UNSELECT, 0, 0, 0});
+            out = Register{merged, then_value.type};
+            return true;
+        }
+
+        return false;
+    }
+};
+
+using Rows = std::vector<uint32_t>;
+
+// Filas de un SELECT: las que toman la rama y las que no
+struct Selection {
+    Rows taken;
+    Rows other;
+    bool in_else = false;
+};
+
+// f(i) para cada fila activa: todas las del bloque si rows es nullptr (un
+// ciclo simple que el compilador puede vectorizar) o las de la selección
+template <typename F>
+inline void for_rows(const Rows* rows, size_t count, F f) {
+    if (!rows) {
+        for (size_t i = 0; i < count; ++i) f(i);
+    } else {
+        for (uint32_t i : *rows) f(i);
+    }
+}
+
+template <typename F>
+inline void binary(int* dst, const int* a, const int* b, const Rows* rows, size_t count, F f) {
+    for_rows(rows, count, [&](size_t i) { dst[i] = f(a[i], b[i]); });
+}
+
+std::shared_ptr<Object> make_value(ObjectType type, int value) {
+    if (type == ObjectType::BOOLEAN_OBJ) return std::make_shared<Boolean>(value != 0);
+    return std::make_shared<Integer>(value);
+}
+
+bool parse_field(std::string_view text, ObjectType& type, int& value) {
+    if (text == "true" || text == "false") {
+        type = ObjectType::BOOLEAN_OBJ;
+        value = text == "true";
+        return true;
+    }
+    type = ObjectType::INTEGER_OBJ;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+}
+
+std::vector<std::string_view> split_fields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    while (true) {
+        size_t comma = line.find(',');
+        std::string_view field = line.substr(0, comma);
+        while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) field.remove_prefix(1);
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\t' || field.back() == '\r')) {
+            field.remove_suffix(1);
+        }
+        fields.push_back(field);
+        if (comma == std::string_view::npos) return fields;
+        line.remove_prefix(comma + 1);
+    }
+}
+
+} // namespace
+
+std::string BatchResult::inspect(size_t row) const {
+    if (!vectorized) return objects[row] ? objects[row]->inspect() : "";
+    int value = column.values[row];
+    if (column.type == ObjectType::BOOLEAN_OBJ) return value ? "true" : "false";
+    return std::to_string(value);
+}
+
+std::unique_ptr<BatchProgram> BatchProgram::compile(std::shared_ptr<Program> program, Inputs inputs,
+                                                    std::shared_ptr<Environment> globals) {
+    // Sellado, cada fila corre en un fork O(1) y ninguna lo modifica
+    if (!globals) globals = std::make_shared<Environment>();
+    globals->seal();
+
+    // Un entorno con una fila de muestra: para la inferencia y el inlining
+    // vale lo mismo que el de cualquier fila, porque solo miran los tipos
+    auto sample = globals->fork();
+    for (const auto& [name, type] : inputs) sample->set(name, make_value(type, 0));
+    auto type_errors = infer_types(program.get(), sample);
+    if (!type_errors.empty()) {
+        std::cerr << "Errores de tipos:\n";
+        for (const auto& err : type_errors) {
+            std::cerr << "  - " << err << "\n";
+        }
+        return nullptr;
+    }
+    inline_calls(program.get(), sample);
+
+    std::unique_ptr<BatchProgram> batch(new BatchProgram(std::move(program), std::move(inputs), std::move(globals)));
+    BatchCompiler compiler(batch->inputs);
+    Register result;
+    if (compiler.compile(*batch->program, result)) {
+        batch->is_vectorized = true;
+        batch->code = std::move(compiler.code);
+        batch->registers = compiler.registers;
+        batch->result_register = result.index;
+        batch->result_type = result.type;
+    }
+    return batch;
+}
+
+BatchResult BatchProgram::run(const std::vector<Column>& columns) const {
+    size_t rows = columns.empty() ? 0 : columns[0].values.size();
+    return is_vectorized ? run_vectorized(columns, rows) : run_each_row(columns, rows);
+}
+
+BatchResult BatchProgram::run_vectorized(const std::vector<Column>& columns, size_t rows) const {
+    BatchResult result;
+    result.vectorized = true;
+    result.column.type = result_type;
+    result.column.values.resize(rows);
+
+    // Los temporales de un bloque; las entradas se leen de las columnas
+    size_t first_temp = inputs.size();
+    std::vector<int> storage((registers - first_temp) * BATCH_ROWS);
+    std::vector<const int*> reg(registers);
+    for (size_t r = first_temp; r < registers; ++r) reg[r] = storage.data() + (r - first_temp) * BATCH_ROWS;
+    auto dst_of = [&](int r) { return storage.data() + (static_cast<size_t>(r) - first_temp) * BATCH_ROWS; };
+
+    // deque: crecer no mueve la selección activa
+    std::deque<Selection> selections;
+    size_t depth = 0;
+
+    for (size_t first = 0; first < rows; first += BATCH_ROWS) {
+        size_t count = std::min(BATCH_ROWS, rows - first);
+        for (size_t r = 0; r < first_temp; ++r) reg[r] = columns[r].values.data() + first;
+        const Rows* active = nullptr;
+
+        for (const Instr& in : code) {
+            // Las instrucciones de selección no escriben y CONST lleva el valor en a
+            int* dst = in.dst >= static_cast<int>(first_temp) ? dst_of(in.dst) : nullptr;
+            const int* a = in.op == Op::CONST ? nullptr : reg[in.a];
+            const int* b = reg[in.b];
+            switch (in.op) {
+                case Op::CONST: {
+                    int value = in.a;
+                    for_rows(active, count, [&](size_t i) { dst[i] = value; });
+                    break;
+                }
+                case Op::ADD: binary(dst, a, b, active, count, [](int x, int y) { return x + y; }); break;
+                case Op::SUB: binary(dst, a, b, active, count, [](int x, int y) { return x - y; }); break;
+                case Op::MUL: binary(dst, a, b, active, count, [](int x, int y) { return x * y; }); break;
+                case Op::DIV: binary(dst, a, b, active, count, [](int x, int y) { return x / y; }); break;
+                case Op::EQ: binary(dst, a, b, active, count, [](int x, int y) { return int(x == y); }); break;
+                case Op::NE: binary(dst, a, b, active, count, [](int x, int y) { return int(x != y); }); break;
+                case Op::LT: binary(dst, a, b, active, count, [](int x, int y) { return int(x < y); }); break;
+                case Op::GT: binary(dst, a, b, active, count, [](int x, int y) { return int(x > y); }); break;
+                case Op::NEG: for_rows(active, count, [&](size_t i) { dst[i] = -a[i]; }); break;
+                case Op::NOT: for_rows(active, count, [&](size_t i) { dst[i] = !a[i]; }); break;
+                case Op::MOVE: for_rows(active, count, [&](size_t i) { dst[i] = a[i]; }); break;
+                case Op::SELECT: {
+                    if (depth == selections.size()) selections.emplace_back();
+                    Selection& selection = selections[depth++];
+                    selection.taken.clear();
+                    selection.other.clear();
+                    selection.in_else = false;
+                    for_rows(active, count, [&](size_t i) {
+                        (a[i] ? selection.taken : selection.other).push_back(static_cast<uint32_t>(i));
+                    });
+                    active = &selection.taken;
+                    break;
+                }
+                case Op::SELECT_ELSE:
+                    selections[depth - 1].in_else = true;
+                    active = &selections[depth - 1].other;
+                    break;
+                case Op::UNSELECT:
+                    --depth;
+                    if (depth == 0) {
+                        active = nullptr;
+                    } else {
+                        Selection& outer = selections[depth - 1];
+                        active = outer.in_else ? &outer.other : &outer.taken;
+                    }
+                    break;
+            }
+        }
+
+        const int* value = reg[result_register];
+        std::copy(value, value + count, result.column.values.begin() + static_cast<std::ptrdiff_t>(first));
+    }
+    return result;
+}
+
+// El camino general: un eval() por fila en su propia copia de globals
+BatchResult BatchProgram::run_each_row(const std::vector<Column>& columns, size_t rows) const {
+    BatchResult result;
+    result.objects.resize(rows);
+    for (size_t row = 0; row < rows; ++row) {
+        auto env = globals->fork();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            env->set(inputs[i].first, make_value(columns[i].type, columns[i].values[row]));
+        }
+        result.objects[row] = eval(program.get(), env);
+    }
+    return result;
+}
+
+bool read_columns_csv(const std::string& path, BatchProgram::Inputs& names, std::vector<Column>& columns) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "No se pudo abrir " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(input, line)) {
+        std::cerr << path << ": falta la línea con los nombres de las columnas\n";
+        return false;
+    }
+    names.clear();
+    for (std::string_view name : split_fields(line)) {
+        if (name.empty()) {
+            std::cerr << path << ":1: nombre de columna vacío\n";
+            return false;
+        }
+        names.emplace_back(std::string(name), ObjectType::INTEGER_OBJ);
+    }
+    columns.assign(names.size(), Column{});
+
+    size_t line_number = 1;
+    bool typed = false;
+    while (std::getline(input, line)) {
+        ++line_number;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        auto fields = split_fields(line);
+        if (fields.size() != names.size()) {
+            std::cerr << path << ":" << line_number << ": se esperaban " << names.size() << " valores\n";
+            return false;
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            ObjectType type;
+            int value;
+            if (!parse_field(fields[i], type, value)) {
+                std::cerr << path << ":" << line_number << ": valor inválido '" << fields[i] << "'\n";
+                return false;
+            }
+            if (!typed) {
+                names[i].second = type;
+                columns[i].type = type;
+            } else if (type != columns[i].type) {
+                std::cerr << path << ":" << line_number << ": la columna " << names[i].first << " es de "
+                          << (columns[i].type == ObjectType::INTEGER_OBJ ? "enteros" : "booleanos") << "\n";
+                return false;
+            }
+            columns[i].values.push_back(value);
+        }
+        typed = true;
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+
+// Columna de entrada o de resultado: un valor por fila, todos del mismo tipo
+struct Column {
+    ObjectType type = ObjectType::INTEGER_OBJ;   // INTEGER_OBJ o BOOLEAN_OBJ
+    std::vector<int> values;                     // los booleanos como 0 o 1
+};
+
+// Resultado de un lote, una entrada por fila
+struct BatchResult {
+    bool vectorized = false;
+    Column column;                                   // si vectorized
+    std::vector<std::shared_ptr<Object>> objects;    // si no (nullptr donde la fila falló)
+
+    size_t size() const { return vectorized ? column.values.size() : objects.size(); }
+    // Como lo muestra inspect(); vacío si la fila falló
+    std::string inspect(size_t row) const;
+};
+
+// Un programa evaluado sobre muchas filas de entrada. Cada fila da lo mismo
+// que eval() del programa en una copia de globals (ver Environment::fork) con
+// las entradas ligadas a los valores de esa fila, pero sin crear entornos ni objetos por fila: el
+// programa se compila a operaciones sobre columnas que recorren las filas en
+// bloques de BATCH_ROWS, y los if se ejecutan restringiendo cada rama a las
+// filas que la toman (vectores de selección).
+//
+// Se vectorizan los let y las expresiones de enteros y booleanos sobre las
+// entradas (operadores, literales, variables e if con else de una expresión
+// por rama). Cualquier otra cosa (llamadas, ciclos, funciones, operaciones
+// que fallarían por el tipo) hace que el lote corra fila por fila con eval().
+class BatchProgram {
+public:
+    static constexpr size_t BATCH_ROWS = 1024;
+
+    using Inputs = std::vector<std::pair<std::string, ObjectType>>;
+
+    // nullptr si el programa tiene errores de tipos (ya informados). globals
+    // (por ejemplo un preludio ya cargado) queda sellado, como en
+    // CompiledProgram::compile.
+    static std::unique_ptr<BatchProgram> compile(std::shared_ptr<Program> program, Inputs inputs,
+                                                 std::shared_ptr<Environment> globals = nullptr);
+
+    bool vectorized() const { return is_vectorized; }
+
+    // columns en el orden de las entradas, todas del mismo largo y tipo
+    BatchResult run(const std::vector<Column>& columns) const;
+
+    enum class Op : unsigned char {
+        CONST,         // dst = a en cada fila
+        ADD, SUB, MUL, DIV,
+        EQ, NE, LT, GT,
+        NEG, NOT,
+        MOVE,          // dst = a
+        SELECT,        // restringe las filas a las que tienen a verdadero
+        SELECT_ELSE,   // pasa a las filas que el SELECT dejó afuera
+        UNSELECT,      // vuelve a las filas de antes del SELECT
+    };
+
+    struct Instr {
+        Op op;
+        int dst;
+        int a;
+        int b;
+    };
+
+private:
+    BatchProgram(std::shared_ptr<Program> program, Inputs inputs, std::shared_ptr<Environment> globals)
+        : program(std::move(program)), inputs(std::move(inputs)), globals(std::move(globals)) {}
+
+    std::shared_ptr<Program> program;
+    Inputs inputs;
+    std::shared_ptr<Environment> globals;
+    bool is_vectorized = false;
+    // Registros: primero las entradas, después los temporales
+    std::vector<Instr> code;
+    size_t registers = 0;
+    int result_register = 0;
+    ObjectType result_type = ObjectType::INTEGER_OBJ;
+
+    BatchResult run_vectorized(const std::vector<Column>& columns, size_t rows) const;
+    BatchResult run_each_row(const std::vector<Column>& columns, size_t rows) const;
+};
+
+// Columnas desde un CSV: la primera línea tiene los nombres y cada una de las
+// siguientes una fila de enteros o true/false (el tipo de cada columna sale
+// de la primera fila). false si no se pudo leer (ya informado).
+bool read_columns_csv(const std::string& path, BatchProgram::Inputs& names, std::vector<Column>& columns);
+
+#endif // BATCH_H
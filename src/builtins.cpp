@@ -0,0 +1,109 @@
+#include "builtins.h"
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "scheduler.h"
+
+void BlockingHostContext::after(std::chrono::milliseconds delay, std::function<void()> fn) {
+    std::this_thread::sleep_for(delay);
+    fn();
+}
+
+void BlockingHostContext::run_blocking(std::function<std::shared_ptr<Object>()> work, HostCompletion done) {
+    done(work());
+}
+
+// Almacén clave-valor local, reemplazo de uno remoto. Las claves son enteros.
+static std::mutex kv_mutex;
+static std::unordered_map<int, std::shared_ptr<Object>> kv_store;
+
+static bool integer_arg(const std::vector<std::shared_ptr<Object>>& args, size_t i, int& out) {
+    if (!args[i] || args[i]->type() != ObjectType::INTEGER_OBJ) return false;
+    out = std::static_pointer_cast<Integer>(args[i])->value;
+    return true;
+}
+
+static void builtin_sleep(HostContext& host, std::vector<std::shared_ptr<Object>>& args, HostCompletion done) {
+    int ms;
+    if (!integer_arg(args, 0, ms)) {
+        std::cerr << "sleep espera un entero\n";
+        done(nullptr);
+        return;
+    }
+    host.after(std::chrono::milliseconds(ms), [done]() { done(std::make_shared<Null>()); });
+}
+
+static void builtin_kv_set(HostContext& host, std::vector<std::shared_ptr<Object>>& args, HostCompletion done) {
+    int key;
+    if (!integer_arg(args, 0, key) || !args[1]) {
+        std::cerr << "kv_set espera una clave entera y un valor\n";
+        done(nullptr);
+        return;
+    }
+    auto value = args[1];
+    host.run_blocking([key, value]() {
+        std::lock_guard<std::mutex> lock(kv_mutex);
+        kv_store[key] = value;
+        return value;
+    }, std::move(done));
+}
+
+static void builtin_kv_get(HostContext& host, std::vector<std::shared_ptr<Object>>& args, HostCompletion done) {
+    int key;
+    if (!integer_arg(args, 0, key)) {
+        std::cerr << "kv_get espera una clave entera\n";
+        done(nullptr);
+        return;
+    }
+    host.run_blocking([key]() -> std::shared_ptr<Object> {
+        std::lock_guard<std::mutex> lock(kv_mutex);
+        auto it = kv_store.find(key);
+        if (it == kv_store.end()) return std::make_shared<Null>();
+        return it->second;
+    }, std::move(done));
+}
+
+static void builtin_spawn(HostContext&, std::vector<std::shared_ptr<Object>>& args, HostCompletion done) {
+    if (!args[0] || args[0]->type() != ObjectType::FUNCTION_OBJ ||
+        !std::static_pointer_cast<Function>(args[0])->parameters.empty()) {
+        std::cerr << "spawn espera una función sin parámetros\n";
+        done(nullptr);
+        return;
+    }
+    done(spawn_task(std::static_pointer_cast<Function>(args[0])));
+}
+
+static void builtin_join(HostContext& host, std::vector<std::shared_ptr<Object>>& args, HostCompletion done) {
+    if (!args[0] || args[0]->type() != ObjectType::TASK_OBJ) {
+        std::cerr << "join espera una tarea\n";
+        done(nullptr);
+        return;
+    }
+    auto task = std::static_pointer_cast<Task>(args[0]);
+    // Esperar puede bloquear: en el EventLoop va a un hilo auxiliar
+    host.run_blocking([task]() { return task->wait(); }, std::move(done));
+}
+
+std::shared_ptr<Builtin> lookup_builtin(const std::string& name) {
+    static const std::unordered_map<std::string, std::shared_ptr<Builtin>> builtins = {
+        {"sleep", std::make_shared<Builtin>("sleep", 1, builtin_sleep)},
+        {"kv_set", std::make_shared<Builtin>("kv_set", 2, builtin_kv_set)},
+        {"kv_get", std::make_shared<Builtin>("kv_get", 1, builtin_kv_get)},
+        {"spawn", std::make_shared<Builtin>("spawn", 1, builtin_spawn)},
+        {"join", std::make_shared<Builtin>("join", 1, builtin_join)},
+    };
+
+    auto it = builtins.find(name);
+    if (it != builtins.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Object> call_builtin_blocking(const Builtin& builtin, std::vector<std::shared_ptr<Object>>& args) {
+    BlockingHostContext host;
+    std::shared_ptr<Object> result;
+    builtin.fn(host, args, [&result](std::shared_ptr<Object> value) { result = std::move(value); });
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "object.h"
+
+// Servicios que el host ofrece a las funciones builtin. El EventLoop los
+// implementa sin bloquear el hilo; BlockingHostContext los resuelve en el
+// momento, para los evaluadores síncronos.
+class HostContext {
+public:
+    virtual ~HostContext() = default;
+    // Ejecuta fn después de delay
+    virtual void after(std::chrono::milliseconds delay, std::function<void()> fn) = 0;
+    // Ejecuta work (que puede bloquear) fuera del hilo evaluador y entrega su resultado a done
+    virtual void run_blocking(std::function<std::shared_ptr<Object>()> work, HostCompletion done) = 0;
+};
+
+class BlockingHostContext : public HostContext {
+public:
+    void after(std::chrono::milliseconds delay, std::function<void()> fn) override;
+    void run_blocking(std::function<std::shared_ptr<Object>()> work, HostCompletion done) override;
+};
+
+// Builtins disponibles en todos los entornos: sleep(ms), kv_set(k, v), kv_get(k),
+// spawn(f) y join(tarea) (ver scheduler.h).
+// Devuelve nullptr si name no es un builtin.
+std::shared_ptr<Builtin> lookup_builtin(const std::string& name);
+
+// Llama al builtin esperando su resultado en el hilo actual
+std::shared_ptr<Object> call_builtin_blocking(const Builtin& builtin, std::vector<std::shared_ptr<Object>>& args);
+
+#endif // BUILTINS_H
@@ -0,0 +1,68 @@
+#ifndef CALL_FRAMES_H
+#define CALL_FRAMES_H
+
+#include <deque>
+#include <memory>
+#include "environment.h"
+
+// Pila de entornos reutilizables para llamadas cuyo marco no escapa
+// (ver escape_analysis.h). Los Environment viven en un deque, así que sus
+// direcciones son estables y sus tablas se reutilizan entre llamadas.
+// Es thread_local: cada hilo evaluador tiene la suya.
+class FrameStack {
+public:
+    static FrameStack& current() {
+        thread_local FrameStack stack;
+        return stack;
+    }
+
+    Environment* push(std::shared_ptr<Environment> outer) {
+        if (top == frames.size()) {
+            frames.emplace_back();
+        }
+        Environment* frame = &frames[top++];
+        frame->reset(std::move(outer));
+        return frame;
+    }
+
+    void pop() {
+        frames[--top].reset(nullptr);
+    }
+
+private:
+    std::deque<Environment> frames;
+    size_t top = 0;
+};
+
+// Marco de una llamada: en la pila de marcos si no escapa, en el heap si
+// alguna clausura puede capturarlo.
+class CallFrame {
+public:
+    CallFrame(std::shared_ptr<Environment> outer, bool escapes) : on_stack(!escapes) {
+        if (on_stack) {
+            // shared_ptr sin dueño: el marco pertenece a la FrameStack
+            frame_env = std::shared_ptr<Environment>(std::shared_ptr<Environment>(),
+                                                     FrameStack::current().push(std::move(outer)));
+        } else {
+            frame_env = make_pooled<Environment>(std::move(outer));
+        }
+    }
+
+    ~CallFrame() {
+        if (on_stack) {
+            frame_env.reset();
+            FrameStack::current().pop();
+        }
+    }
+
+    CallFrame(const CallFrame&) = delete;
+    CallFrame& operator=(const CallFrame&) = delete;
+
+    const std::shared_ptr<Environment>& env() const { return frame_env; }
+
+private:
+    bool on_stack;
+    std::shared_ptr<Environment> frame_env;
+};
+
+#endif // CALL_FRAMES_H
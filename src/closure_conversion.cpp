@@ -0,0 +1,243 @@
+#include "closure_conversion.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "escape_analysis.h"
+
+namespace {
+
+// Cómo liga un nombre una función
+struct Binding {
+    int count = 0;          // parámetros, lets y nombre propio que lo ligan
+    bool changes = false;   // asignado (también desde una clausura) o ligado en un ciclo
+    bool defined = false;   // ya ligado en el punto actual del recorrido
+};
+
+// Una función que rodea al punto actual del recorrido
+struct Scope {
+    std::unordered_map<std::string, Binding> bindings;
+    std::vector<std::string> lets;
+    std::vector<std::string> defined;           // lets ya ligados, para deshacerlos al salir de su bloque
+    std::vector<std::string> free;              // usados sin ligarlos, en orden de aparición
+    std::unordered_set<std::string> free_set;
+    std::unordered_set<std::string> assigned;   // también desde las funciones de adentro
+    bool opaque = false;                        // contiene cuerpos diferidos: no se sabe qué usan
+};
+
+// Ligaduras de la función: sus lets (sin entrar a las funciones de adentro) y
+// las asignaciones de todo su cuerpo
+void prescan(const Node* node, Scope& scope, bool in_loop, bool nested) {
+    if (!node) return;
+
+    if (auto block = dynamic_cast<const BlockStatement*>(node)) {
+        for (const auto& stmt : block->statements) prescan(stmt.get(), scope, in_loop, nested);
+    } else if (auto expr_stmt = dynamic_cast<const ExpressionStatement*>(node)) {
+        prescan(expr_stmt->expression.get(), scope, in_loop, nested);
+    } else if (auto let_stmt = dynamic_cast<const LetStatement*>(node)) {
+        if (!nested) {
+            Binding& binding = scope.bindings[let_stmt->name];
+            ++binding.count;
+            if (in_loop) binding.changes = true;
+            scope.lets.push_back(let_stmt->name);
+        }
+        prescan(let_stmt->value.get(), scope, in_loop, nested);
+    } else if (auto return_stmt = dynamic_cast<const ReturnStatement*>(node)) {
+        prescan(return_stmt->value.get(), scope, in_loop, nested);
+    } else if (auto while_stmt = dynamic_cast<const WhileStatement*>(node)) {
+        prescan(while_stmt->condition.get(), scope, true, nested);
+        prescan(while_stmt->body.get(), scope, true, nested);
+    } else if (auto for_stmt = dynamic_cast<const ForStatement*>(node)) {
+        prescan(for_stmt->init.get(), scope, true, nested);
+        prescan(for_stmt->condition.get(), scope, true, nested);
+        prescan(for_stmt->update.get(), scope, true, nested);
+        prescan(for_stmt->body.get(), scope, true, nested);
+    } else if (auto assign = dynamic_cast<const AssignExpression*>(node)) {
+        scope.assigned.insert(assign->name);
+        prescan(assign->value.get(), scope, in_loop, nested);
+    } else if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        prescan(prefix->right.get(), scope, in_loop, nested);
+    } else if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        prescan(infix->left.get(), scope, in_loop, nested);
+        prescan(infix->right.get(), scope, in_loop, nested);
+    } else if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+        prescan(if_expr->condition.get(), scope, in_loop, nested);
+        prescan(if_expr->consequence.get(), scope, in_loop, nested);
+        prescan(if_expr->alternative.get(), scope, in_loop, nested);
+    } else if (auto call = dynamic_cast<const CallExpression*>(node)) {
+        prescan(call->function.get(), scope, in_loop, nested);
+        for (const auto& arg : call->arguments) prescan(arg.get(), scope, in_loop, nested);
+    } else if (auto func = dynamic_cast<const FunctionLiteral*>(node)) {
+        if (!func->body || func->body->lazy) {
+            scope.opaque = true;
+        } else {
+            prescan(func->body.get(), scope, in_loop, true);
+        }
+    }
+}
+
+class Converter {
+public:
+    void statement(Statement* node) {
+        if (!node) return;
+
+        if (auto block = dynamic_cast<BlockStatement*>(node)) {
+            size_t mark = defined_mark();
+            for (auto& stmt : block->statements) statement(stmt.get());
+            undefine(mark);
+        } else if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(node)) {
+            expression(expr_stmt->expression.get());
+        } else if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
+            if (auto func = dynamic_cast<FunctionLiteral*>(let_stmt->value.get())) {
+                function(func, &let_stmt->name);
+            } else {
+                expression(let_stmt->value.get());
+            }
+            if (scopes.empty()) return;
+            Scope& scope = scopes.back();
+            Binding& binding = scope.bindings[let_stmt->name];
+            if (!binding.defined) {
+                binding.defined = true;
+                scope.defined.push_back(let_stmt->name);
+            }
+        } else if (auto return_stmt = dynamic_cast<ReturnStatement*>(node)) {
+            expression(return_stmt->value.get());
+        } else if (auto while_stmt = dynamic_cast<WhileStatement*>(node)) {
+            expression(while_stmt->condition.get());
+            statement(while_stmt->body.get());
+        } else if (auto for_stmt = dynamic_cast<ForStatement*>(node)) {
+            size_t mark = defined_mark();
+            statement(for_stmt->init.get());
+            expression(for_stmt->condition.get());
+            statement(for_stmt->update.get());
+            statement(for_stmt->body.get());
+            undefine(mark);
+        }
+    }
+
+private:
+    // deque: las referencias a las de afuera siguen valiendo al entrar a otra
+    std::deque<Scope> scopes;
+
+    void expression(Expression* node) {
+        if (!node) return;
+
+        if (auto ident = dynamic_cast<Identifier*>(node)) {
+            use(ident->value);
+        } else if (auto assign = dynamic_cast<AssignExpression*>(node)) {
+            use(assign->name);
+            expression(assign->value.get());
+        } else if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+            expression(prefix->right.get());
+        } else if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+            expression(infix->left.get());
+            expression(infix->right.get());
+        } else if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
+            expression(if_expr->condition.get());
+            statement(if_expr->consequence.get());
+            statement(if_expr->alternative.get());
+        } else if (auto call = dynamic_cast<CallExpression*>(node)) {
+            expression(call->function.get());
+            for (auto& arg : call->arguments) expression(arg.get());
+        } else if (auto func = dynamic_cast<FunctionLiteral*>(node)) {
+            function(func, nullptr);
+        }
+    }
+
+    // self: nombre del let que liga al literal
+    void function(FunctionLiteral* func, const std::string* self) {
+        if (!func->body || func->body->lazy) {
+            if (!scopes.empty()) scopes.back().opaque = true;
+            return;
+        }
+
+        Scope& scope = scopes.emplace_back();
+        if (self) ++scope.bindings[*self].count;
+        for (const auto& param : func->parameters) ++scope.bindings[param].count;
+        for (auto& [name, binding] : scope.bindings) binding.defined = true;
+        prescan(func->body.get(), scope, false, false);
+        for (const auto& name : scope.assigned) {
+            auto it = scope.bindings.find(name);
+            if (it != scope.bindings.end()) it->second.changes = true;
+        }
+
+        for (auto& stmt : func->body->statements) statement(stmt.get());
+
+        Scope inner = std::move(scopes.back());
+        scopes.pop_back();
+        func->captures.clear();
+        func->converted = !scopes.empty() && convertible(inner, func->captures);
+        if (!func->converted) func->captures.clear();
+        // Lo que usa el literal sin ligarlo lo usa también la función que lo crea
+        for (const auto& name : inner.free) use(name);
+        func->body->frame_escapes = frame_escapes(func->body.get());
+    }
+
+    bool convertible(const Scope& inner, std::vector<std::string>& captures) const {
+        if (inner.opaque) return false;
+        for (const auto& name : inner.lets) {
+            if (find_binding(name)) return false;
+        }
+        for (const auto& name : inner.free) {
+            const Scope* owner = nullptr;
+            const Binding* binding = find_binding(name, &owner);
+            if (!binding) continue;   // global o builtin
+            if (owner->opaque || binding->count != 1 || binding->changes || !binding->defined) return false;
+            captures.push_back(name);
+        }
+        return true;
+    }
+
+    const Binding* find_binding(const std::string& name, const Scope** owner = nullptr) const {
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            auto it = scope->bindings.find(name);
+            if (it == scope->bindings.end()) continue;
+            if (owner) *owner = &*scope;
+            return &it->second;
+        }
+        return nullptr;
+    }
+
+    void use(const std::string& name) {
+        if (scopes.empty()) return;
+        Scope& scope = scopes.back();
+        if (scope.bindings.count(name)) return;
+        if (scope.free_set.insert(name).second) scope.free.push_back(name);
+    }
+
+    size_t defined_mark() const {
+        return scopes.empty() ? 0 : scopes.back().defined.size();
+    }
+
+    // Los lets de un bloque que termina ya no preceden a lo que sigue
+    void undefine(size_t mark) {
+        if (scopes.empty()) return;
+        Scope& scope = scopes.back();
+        while (scope.defined.size() > mark) {
+            scope.bindings[scope.defined.back()].defined = false;
+            scope.defined.pop_back();
+        }
+    }
+};
+
+} // namespace
+
+void convert_closures(Statement* stmt) {
+    Converter converter;
+    converter.statement(stmt);
+}
+
+std::shared_ptr<Function> make_closure(const FunctionLiteral* literal, const std::shared_ptr<Environment>& env) {
+    if (!literal->converted) return make_pooled<Function>(literal->parameters, literal->body, env);
+
+    const std::shared_ptr<Environment>* global = &env;
+    while ((*global)->outer_env()) global = &(*global)->outer_env();
+    if (literal->captures.empty()) return make_pooled<Function>(literal->parameters, literal->body, *global);
+
+    auto captured = make_pooled<Environment>(*global);
+    for (const auto& name : literal->captures) {
+        if (auto value = env->get(name)) captured->set(name, std::move(value));
+    }
+    return make_pooled<Function>(literal->parameters, literal->body, std::move(captured));
+}
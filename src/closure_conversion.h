@@ -0,0 +1,35 @@
+#ifndef CLOSURE_CONVERSION_H
+#define CLOSURE_CONVERSION_H
+
+#include <memory>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+
+// Conversión de clausuras. Un literal de función anidado en otra función
+// captura, en lugar del marco donde se evalúa (y con él toda la cadena de
+// marcos exteriores), solo sus variables libres que son locales de las
+// funciones que lo rodean: se copian a un entorno chico cuyo exterior es el
+// global. La clausura no retiene el resto de las ligaduras, buscar una
+// variable no recorre los marcos intermedios y el marco de la función que la
+// crea puede ir a la pila de marcos (ver escape_analysis.h).
+//
+// Copiar el valor equivale a compartir la ligadura solo si esta ya existe al
+// crear la clausura y no cambia después. Por eso un literal se convierte
+// (FunctionLiteral::converted) solo si cada variable libre que liga una
+// función exterior es un parámetro, el nombre del let que liga a esa función
+// (ver bind_let) o un let que precede al literal fuera de todo ciclo, y nadie
+// la asigna ni la vuelve a ligar. Además el literal no puede ligar con let un
+// nombre de una función exterior: antes de ese let se vería el de afuera.
+// Las variables libres que no son de ninguna función exterior son globales o
+// builtins y se buscan como siempre.
+//
+// Se analiza cada sentencia de nivel superior al parsearla (se recalcula de
+// paso frame_escapes de cada cuerpo). Los cuerpos diferidos (ver LazyBody)
+// no se miran: sus literales capturan el marco entero.
+void convert_closures(Statement* stmt);
+
+// Valor de evaluar literal en env
+std::shared_ptr<Function> make_closure(const FunctionLiteral* literal, const std::shared_ptr<Environment>& env);
+
+#endif // CLOSURE_CONVERSION_H
@@ -0,0 +1,60 @@
+#include "compiled_program.h"
+#include <iostream>
+#include "evaluator.h"
+#include "inlining.h"
+#include "parallel_parser.h"
+#include "type_inference.h"
+
+std::unique_ptr<CompiledProgram> CompiledProgram::compile(const std::string& source, Inputs inputs,
+                                                          std::vector<std::string>& errors,
+                                                          std::shared_ptr<Environment> globals) {
+    size_t previous_errors = errors.size();
+    for (const auto& [name, type] : inputs) {
+        if (type != ObjectType::INTEGER_OBJ && type != ObjectType::BOOLEAN_OBJ) {
+            errors.push_back("La entrada " + name + " debe ser entera o booleana");
+        }
+    }
+    std::unique_ptr<Program> program = parse_source(source, errors);
+    if (errors.size() > previous_errors) return nullptr;
+
+    // Sellado, cada fork de run() es O(1) y ninguna ejecución lo modifica
+    if (!globals) globals = std::make_shared<Environment>();
+    globals->seal();
+
+    // Una ejecución de muestra: la inferencia y el inlining solo miran los
+    // tipos, que son los mismos en todas
+    auto sample = globals->fork();
+    for (const auto& [name, type] : inputs) {
+        if (type == ObjectType::BOOLEAN_OBJ) {
+            sample->set(name, std::make_shared<Boolean>(false));
+        } else {
+            sample->set(name, std::make_shared<Integer>(0));
+        }
+    }
+    auto type_errors = infer_types(program.get(), sample);
+    if (!type_errors.empty()) {
+        errors.insert(errors.end(), type_errors.begin(), type_errors.end());
+        return nullptr;
+    }
+    inline_calls(program.get(), sample);
+
+    return std::unique_ptr<CompiledProgram>(new CompiledProgram(std::move(program), std::move(inputs), std::move(globals)));
+}
+
+std::shared_ptr<Object> CompiledProgram::run(std::span<const std::shared_ptr<Object>> values) const {
+    if (values.size() != input_types.size()) {
+        std::cerr << "Se esperaban " << input_types.size() << " entradas y llegaron " << values.size() << "\n";
+        return nullptr;
+    }
+    auto env = globals->fork();
+    for (size_t i = 0; i < values.size(); ++i) {
+        const auto& [name, type] = input_types[i];
+        // Los tipos marcados por la inferencia cuentan con el tipo declarado
+        if (!values[i] || values[i]->type() != type) {
+            std::cerr << "La entrada " << name << " no es del tipo declarado\n";
+            return nullptr;
+        }
+        env->set(name, values[i]);
+    }
+    return eval(program.get(), env);
+}
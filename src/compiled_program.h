@@ -0,0 +1,58 @@
+#ifndef COMPILED_PROGRAM_H
+#define COMPILED_PROGRAM_H
+
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+
+// API para embeber el intérprete: un programa se parsea, se analiza (tipos,
+// inlining) una sola vez y después se ejecuta muchas veces con distintos
+// valores en sus entradas.
+//
+//     std::vector<std::string> errors;
+//     auto program = CompiledProgram::compile("x * 2 + y;", {{"x", ObjectType::INTEGER_OBJ},
+//                                                            {"y", ObjectType::INTEGER_OBJ}}, errors);
+//     auto result = program->run({std::make_shared<Integer>(3), std::make_shared<Integer>(4)});
+//
+// Cada ejecución corre en una copia O(1) de globals (ver Environment::fork),
+// así que lo que liga o asigna no lo ve la siguiente. compile() sella globals:
+// una función de globals que asigna una variable de globals es un error de
+// ejecución, no una escritura compartida. Por eso varios hilos pueden llamar
+// a run() a la vez.
+class CompiledProgram {
+public:
+    // Entradas: variables que el programa lee sin ligarlas, con su tipo
+    // (INTEGER_OBJ o BOOLEAN_OBJ); la inferencia de tipos cuenta con ellos
+    using Inputs = std::vector<std::pair<std::string, ObjectType>>;
+
+    // nullptr con los errores de parsing o de tipos en errors. globals (por
+    // ejemplo un preludio ya cargado) queda sellado (ver Environment::seal).
+    static std::unique_ptr<CompiledProgram> compile(const std::string& source, Inputs inputs,
+                                                    std::vector<std::string>& errors,
+                                                    std::shared_ptr<Environment> globals = nullptr);
+
+    // values en el orden de las entradas. nullptr si la ejecución falló (el
+    // error ya se informó) o si un valor no es del tipo de su entrada.
+    std::shared_ptr<Object> run(std::span<const std::shared_ptr<Object>> values) const;
+
+    std::shared_ptr<Object> run(std::initializer_list<std::shared_ptr<Object>> values) const {
+        return run(std::span<const std::shared_ptr<Object>>(values.begin(), values.size()));
+    }
+
+    const Inputs& inputs() const { return input_types; }
+
+private:
+    CompiledProgram(std::unique_ptr<Program> program, Inputs inputs, std::shared_ptr<Environment> globals)
+        : program(std::move(program)), input_types(std::move(inputs)), globals(std::move(globals)) {}
+
+    std::unique_ptr<Program> program;
+    Inputs input_types;
+    std::shared_ptr<Environment> globals;
+};
+
+#endif // COMPILED_PROGRAM_H
@@ -1,34 +1,199 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include <cassert>
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 #include "object.h"
+#include "pool_allocator.h"
+
+// Resultado de Environment::assign
+enum class AssignResult { ASSIGNED, UNDEFINED, READ_ONLY };
 
 class Environment {
 public:
-    Environment() = default;
+    // Los nodos de la tabla salen del pool, igual que el propio entorno
+    using Bindings = std::unordered_map<std::string, std::shared_ptr<Object>, std::hash<std::string>,
+                                        std::equal_to<std::string>,
+                                        PoolAllocator<std::pair<const std::string, std::shared_ptr<Object>>>>;
+
+    Environment() { profile_allocation(this, typeid(Environment), sizeof(Environment)); }
     explicit Environment(std::shared_ptr<Environment> outer_env)
-        : outer(outer_env) {}
+        : outer(outer_env) {
+        profile_allocation(this, typeid(Environment), sizeof(Environment));
+    }
+    ~Environment() { profile_release(this); }
 
-    std::shared_ptr<Object> get(const std::string& name) {
-        if (store.find(name) != store.end()) {
-            return store[name];
-        } else if (outer) {
+    // Solo lectura: varios hilos pueden consultar a la vez un entorno que
+    // nadie modifica (por ejemplo el preludio compartido del servidor)
+    std::shared_ptr<Object> get(const std::string& name) const {
+        auto it = store.find(name);
+        if (it != store.end()) {
+            return it->second;
+        }
+        for (const Layer* layer = frozen.get(); layer; layer = layer->below.get()) {
+            auto found = layer->bindings.find(name);
+            if (found != layer->bindings.end()) return found->second;
+        }
+        if (outer) {
             return outer->get(name);
         } else {
             return nullptr;
         }
     }
 
+    // Liga en este entorno, que no puede estar sellado: un let siempre
+    // escribe en el entorno de la ejecución o de la llamada en curso
     void set(const std::string& name, std::shared_ptr<Object> value) {
+        // Otros hilos leen un entorno sellado sin lock: escribirlo es un error
+        // del intérprete, no del script
+        assert(!sealed);
         store[name] = value;
     }
 
+    // Asignación (x = valor): reemplaza la ligadura visible más cercana, en
+    // este entorno o en uno exterior. Si está en una capa congelada se copia
+    // al store propio. Un entorno sellado no acepta la escritura (READ_ONLY):
+    // lo comparten todas las ejecuciones, y una función del preludio que
+    // asigna una global llega a él y no a la copia de la ejecución.
+    AssignResult assign(const std::string& name, std::shared_ptr<Object> value) {
+        auto it = store.find(name);
+        if (it != store.end()) {
+            it->second = std::move(value);
+            return AssignResult::ASSIGNED;
+        }
+        if (in_frozen_layer(name)) {
+            if (sealed) return AssignResult::READ_ONLY;
+            store.emplace(name, std::move(value));
+            return AssignResult::ASSIGNED;
+        }
+        return outer ? outer->assign(name, std::move(value)) : AssignResult::UNDEFINED;
+    }
+
+    // Lo que haría assign con name, sin escribir nada
+    AssignResult assignable(const std::string& name) const {
+        if (store.count(name)) return AssignResult::ASSIGNED;
+        if (in_frozen_layer(name)) return sealed ? AssignResult::READ_ONLY : AssignResult::ASSIGNED;
+        return outer ? outer->assignable(name) : AssignResult::UNDEFINED;
+    }
+
+    // Dirección de la ligadura visible de name, para actualizarla en el
+    // lugar. nullptr si no existe o si está en una capa congelada (compartida
+    // con otras copias). Es estable mientras el entorno no se reinicie ni se
+    // congele.
+    std::shared_ptr<Object>* find_slot(const std::string& name) {
+        auto it = store.find(name);
+        if (it != store.end()) {
+            return &it->second;
+        }
+        if (in_frozen_layer(name)) {
+            return nullptr;
+        }
+        return outer ? outer->find_slot(name) : nullptr;
+    }
+
+    // Vacía el entorno para reutilizarlo como otro marco (conserva los buckets)
+    void reset(std::shared_ptr<Environment> outer_env) {
+        store.clear();
+        frozen.reset();
+        sealed = false;
+        outer = std::move(outer_env);
+    }
+
+    // Copia en O(1): este entorno queda sellado (ver seal) y la copia escribe
+    // en su propio store sobre las capas que comparten. Varios hilos pueden
+    // forkear a la vez un entorno ya sellado.
+    std::shared_ptr<Environment> fork() {
+        seal();
+        auto copy = make_pooled<Environment>(outer);
+        copy->frozen = frozen;
+        return copy;
+    }
+
+    // Congela lo escrito y desde ahí no acepta más escrituras, igual que los
+    // entornos alcanzables desde él (exteriores y de sus funciones): así
+    // ninguna ejecución que lo comparta puede modificar lo que ven las demás.
+    // Recorre el grafo una sola vez; sellar un entorno sellado es O(1).
+    void seal() {
+        if (sealed) return;
+        std::vector<Environment*> pending{this};
+        while (!pending.empty()) {
+            Environment* env = pending.back();
+            pending.pop_back();
+            if (env->sealed) continue;
+            env->freeze();
+            env->sealed = true;
+            if (env->outer) pending.push_back(env->outer.get());
+            for (const Layer* layer = env->frozen.get(); layer; layer = layer->below.get()) {
+                for (const auto& [name, value] : layer->bindings) {
+                    if (value && value->type() == ObjectType::FUNCTION_OBJ) {
+                        auto func = static_cast<const Function*>(value.get());
+                        if (func->env) pending.push_back(func->env.get());
+                    }
+                }
+            }
+        }
+    }
+
+    bool is_sealed() const { return sealed; }
+
+    // Acceso para recorrer el grafo de entornos (ver snapshot.h).
+    // Une las capas congeladas con el store propio (gana lo más reciente).
+    Bindings bindings() const {
+        Bindings merged = store;
+        for (const Layer* layer = frozen.get(); layer; layer = layer->below.get()) {
+            merged.insert(layer->bindings.begin(), layer->bindings.end());
+        }
+        return merged;
+    }
+    const std::shared_ptr<Environment>& outer_env() const { return outer; }
+
+    // Solo lo escrito desde el último fork, sin las capas congeladas
+    const Bindings& own_bindings() const { return store; }
+    // Pasa a compartir las capas congeladas de other, que son inmutables:
+    // una copia entre hilos no necesita duplicarlas (ver scheduler.cpp)
+    void share_layers(const Environment& other) { frozen = other.frozen; }
+
 private:
-    std::unordered_map<std::string, std::shared_ptr<Object>> store;
+    struct Layer {
+        Bindings bindings;
+        std::shared_ptr<const Layer> below;
+        size_t depth = 1;
+    };
+    static constexpr size_t MAX_LAYERS = 8;
+
+    void freeze() {
+        if (store.empty()) return;
+        auto layer = make_pooled<Layer>();
+        layer->bindings = std::move(store);
+        layer->below = std::move(frozen);
+        layer->depth = layer->below ? layer->below->depth + 1 : 1;
+        store.clear();
+        // Muchos forks intercalados con escrituras apilan capas: pasado un
+        // límite se aplanan en una sola para que get siga siendo barato
+        if (layer->depth > MAX_LAYERS) {
+            for (const Layer* below = layer->below.get(); below; below = below->below.get()) {
+                layer->bindings.insert(below->bindings.begin(), below->bindings.end());
+            }
+            layer->below.reset();
+            layer->depth = 1;
+        }
+        frozen = std::move(layer);
+    }
+
+    bool in_frozen_layer(const std::string& name) const {
+        for (const Layer* layer = frozen.get(); layer; layer = layer->below.get()) {
+            if (layer->bindings.count(name)) return true;
+        }
+        return false;
+    }
+
+    Bindings store;
+    std::shared_ptr<const Layer> frozen;
     std::shared_ptr<Environment> outer;
+    bool sealed = false;
 };
 
 #endif // ENVIRONMENT_H
@@ -0,0 +1,75 @@
+#include "escape_analysis.h"
+
+static bool contains_function_literal(const Node* node) {
+    if (!node) return false;
+
+    if (auto func = dynamic_cast<const FunctionLiteral*>(node)) {
+        // Una clausura convertida no guarda el marco, solo copias de sus valores
+        return !func->converted;
+    }
+
+    if (auto block = dynamic_cast<const BlockStatement*>(node)) {
+        for (const auto& stmt : block->statements) {
+            if (contains_function_literal(stmt.get())) return true;
+        }
+        return false;
+    }
+
+    if (auto stmt = dynamic_cast<const ExpressionStatement*>(node)) {
+        return contains_function_literal(stmt->expression.get());
+    }
+
+    if (auto let_stmt = dynamic_cast<const LetStatement*>(node)) {
+        return contains_function_literal(let_stmt->value.get());
+    }
+
+    if (auto return_stmt = dynamic_cast<const ReturnStatement*>(node)) {
+        return contains_function_literal(return_stmt->value.get());
+    }
+
+    if (auto while_stmt = dynamic_cast<const WhileStatement*>(node)) {
+        return contains_function_literal(while_stmt->condition.get()) ||
+               contains_function_literal(while_stmt->body.get());
+    }
+
+    if (auto for_stmt = dynamic_cast<const ForStatement*>(node)) {
+        return contains_function_literal(for_stmt->init.get()) ||
+               contains_function_literal(for_stmt->condition.get()) ||
+               contains_function_literal(for_stmt->update.get()) ||
+               contains_function_literal(for_stmt->body.get());
+    }
+
+    if (auto assign = dynamic_cast<const AssignExpression*>(node)) {
+        return contains_function_literal(assign->value.get());
+    }
+
+    if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        return contains_function_literal(prefix->right.get());
+    }
+
+    if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        return contains_function_literal(infix->left.get()) ||
+               contains_function_literal(infix->right.get());
+    }
+
+    if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+        return contains_function_literal(if_expr->condition.get()) ||
+               contains_function_literal(if_expr->consequence.get()) ||
+               contains_function_literal(if_expr->alternative.get());
+    }
+
+    if (auto call = dynamic_cast<const CallExpression*>(node)) {
+        if (contains_function_literal(call->function.get())) return true;
+        for (const auto& arg : call->arguments) {
+            if (contains_function_literal(arg.get())) return true;
+        }
+        return false;
+    }
+
+    // Identificadores y literales no crean clausuras
+    return false;
+}
+
+bool frame_escapes(const BlockStatement* body) {
+    return contains_function_literal(body);
+}
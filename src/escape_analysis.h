@@ -0,0 +1,13 @@
+#ifndef ESCAPE_ANALYSIS_H
+#define ESCAPE_ANALYSIS_H
+
+#include "ast.h"
+
+// Un marco de llamada escapa si el cuerpo de la función puede crear una
+// clausura que lo capture, es decir, si contiene algún FunctionLiteral que
+// no esté convertido (ver closure_conversion.h).
+// Los marcos que no escapan se pueden reservar en la pila de marcos del
+// evaluador en lugar del heap.
+bool frame_escapes(const BlockStatement* body);
+
+#endif // ESCAPE_ANALYSIS_H
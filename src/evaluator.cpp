@@ -1,20 +1,351 @@
 #include "evaluator.h"
+#include "call_frames.h"
+#include "closure_conversion.h"
+#include "loop_tier.h"
+#include "builtins.h"
+#include "parser.h"
+#include "value_numbering.h"
+#include "inlining.h"
+#include "string_object.h"
 #include <iostream>
 
-std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env);
+std::shared_ptr<Object> eval_identifier(Identifier* ident, const std::shared_ptr<Environment>& env) {
+    auto val = env->get(ident->value);
+    if (val) return val;
+    if (auto builtin = lookup_builtin(ident->value)) return builtin;
+    std::cerr << "Identificador no definido: " << ident->value << "\n";
+    return nullptr;
+}
+
+std::shared_ptr<Object> bind_let(LetStatement* let_stmt, std::shared_ptr<Object> val,
+                                 const std::shared_ptr<Environment>& env) {
+    if (val && val->type() == ObjectType::FUNCTION_OBJ) {
+        auto func = std::static_pointer_cast<Function>(val);
+        auto func_env = make_pooled<Environment>(func->env);
+        if (dynamic_cast<FunctionLiteral*>(let_stmt->value.get())) {
+            // Recién creada por el literal y sin otros dueños: se ata a sí misma
+            // sin copiarla
+            func->env = func_env;
+        } else {
+            func = make_pooled<Function>(func->parameters, func->body, func_env);
+            val = func;
+        }
+        func_env->set(let_stmt->name, func);
+    }
+
+    if (val) {
+        env->set(let_stmt->name, val);
+    }
+    return val;
+}
+
+std::shared_ptr<Object> eval_prefix_expression(const std::string& op, const std::shared_ptr<Object>& right) {
+    if (!right) return nullptr;
+
+    if (op == "!") {
+        if (right->type() == ObjectType::BOOLEAN_OBJ) {
+            return std::make_shared<Boolean>(!std::dynamic_pointer_cast<Boolean>(right)->value);
+        } else if (right->type() == ObjectType::NULL_OBJ) {
+            return std::make_shared<Boolean>(true);
+        } else {
+            return std::make_shared<Boolean>(false);
+        }
+    }
+    if (op == "-") {
+        if (right->type() == ObjectType::INTEGER_OBJ) {
+            return std::make_shared<Integer>(-std::dynamic_pointer_cast<Integer>(right)->value);
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Object> eval_infix_expression(const std::string& op, const std::shared_ptr<Object>& left,
+                                              const std::shared_ptr<Object>& right) {
+    if (!left || !right) return nullptr;
+
+    if (left->type() == ObjectType::INTEGER_OBJ && right->type() == ObjectType::INTEGER_OBJ) {
+        int lval = std::dynamic_pointer_cast<Integer>(left)->value;
+        int rval = std::dynamic_pointer_cast<Integer>(right)->value;
+        if (op == "+") return std::make_shared<Integer>(lval + rval);
+        if (op == "-") return std::make_shared<Integer>(lval - rval);
+        if (op == "*") return std::make_shared<Integer>(lval * rval);
+        if (op == "/") return std::make_shared<Integer>(lval / rval);
+        if (op == "==") return std::make_shared<Boolean>(lval == rval);
+        if (op == "!=") return std::make_shared<Boolean>(lval != rval);
+        if (op == "<") return std::make_shared<Boolean>(lval < rval);
+        if (op == ">") return std::make_shared<Boolean>(lval > rval);
+    }
+
+    if (left->type() == ObjectType::BOOLEAN_OBJ && right->type() == ObjectType::BOOLEAN_OBJ) {
+        bool lval = std::dynamic_pointer_cast<Boolean>(left)->value;
+        bool rval = std::dynamic_pointer_cast<Boolean>(right)->value;
+        if (op == "==") return std::make_shared<Boolean>(lval == rval);
+        if (op == "!=") return std::make_shared<Boolean>(lval != rval);
+    }
+
+    if (left->type() == ObjectType::STRING_OBJ && right->type() == ObjectType::STRING_OBJ) {
+        auto lval = std::static_pointer_cast<String>(left);
+        auto rval = std::static_pointer_cast<String>(right);
+        if (op == "+") return concat_strings(lval, rval);
+        if (op == "==") return std::make_shared<Boolean>(lval->equals(*rval));
+        if (op == "!=") return std::make_shared<Boolean>(!lval->equals(*rval));
+        if (op == "<") return std::make_shared<Boolean>(lval->compare(*rval) < 0);
+        if (op == ">") return std::make_shared<Boolean>(lval->compare(*rval) > 0);
+    }
+
+    return nullptr;
+}
+
+bool is_truthy(const std::shared_ptr<Object>& condition) {
+    if (condition->type() == ObjectType::BOOLEAN_OBJ) {
+        return std::dynamic_pointer_cast<Boolean>(condition)->value;
+    } else if (condition->type() == ObjectType::NULL_OBJ) {
+        return false;
+    } else {
+        return true;
+    }
+}
+
+bool loop_continues(const std::shared_ptr<Object>& cond) {
+    return cond && !(cond->type() == ObjectType::BOOLEAN_OBJ && !std::dynamic_pointer_cast<Boolean>(cond)->value);
+}
+
+// Caminos con los tipos ya probados por infer_types: el valor puede faltar
+// (nullptr por un error) pero si está es del tipo marcado
+std::shared_ptr<Object> eval_prefix_expression(const PrefixExpression* prefix, const std::shared_ptr<Object>& right) {
+    if (right && prefix->op == "-" && prefix->right->static_type == static_types::INTEGER) {
+        return std::make_shared<Integer>(-static_cast<Integer*>(right.get())->value);
+    }
+    return eval_prefix_expression(prefix->op, right);
+}
+
+std::shared_ptr<Object> eval_infix_expression(const InfixExpression* infix, const std::shared_ptr<Object>& left,
+                                              const std::shared_ptr<Object>& right) {
+    if (!left || !right) return nullptr;
+    const std::string& op = infix->op;
+    unsigned char left_type = infix->left->static_type;
+    unsigned char right_type = infix->right->static_type;
+
+    if (left_type == static_types::INTEGER && right_type == static_types::INTEGER) {
+        int lval = static_cast<Integer*>(left.get())->value;
+        int rval = static_cast<Integer*>(right.get())->value;
+        switch (op[0]) {
+            case '+': return std::make_shared<Integer>(lval + rval);
+            case '-': return std::make_shared<Integer>(lval - rval);
+            case '*': return std::make_shared<Integer>(lval * rval);
+            case '/': return std::make_shared<Integer>(lval / rval);
+            case '=': return std::make_shared<Boolean>(lval == rval);
+            case '!': return std::make_shared<Boolean>(lval != rval);
+            case '<': return std::make_shared<Boolean>(lval < rval);
+            case '>': return std::make_shared<Boolean>(lval > rval);
+        }
+    }
+
+    if (left_type == static_types::BOOLEAN && right_type == static_types::BOOLEAN) {
+        bool lval = static_cast<Boolean*>(left.get())->value;
+        bool rval = static_cast<Boolean*>(right.get())->value;
+        if (op == "==") return std::make_shared<Boolean>(lval == rval);
+        if (op == "!=") return std::make_shared<Boolean>(lval != rval);
+    }
+
+    return eval_infix_expression(op, left, right);
+}
+
+bool is_truthy(const Expression* condition_node, const std::shared_ptr<Object>& condition) {
+    if (condition_node->static_type == static_types::BOOLEAN) {
+        return static_cast<Boolean*>(condition.get())->value;
+    }
+    return is_truthy(condition);
+}
+
+bool loop_continues(const Expression* condition_node, const std::shared_ptr<Object>& cond) {
+    if (condition_node->static_type == static_types::BOOLEAN) {
+        return cond && static_cast<Boolean*>(cond.get())->value;
+    }
+    return loop_continues(cond);
+}
+
+std::shared_ptr<Function> check_callable(const std::shared_ptr<Object>& func_obj, size_t arg_count) {
+    if (!func_obj || func_obj->type() != ObjectType::FUNCTION_OBJ) {
+        std::cerr << "Llamando a algo que no es funcion\n";
+        return nullptr;
+    }
+
+    auto func = std::dynamic_pointer_cast<Function>(func_obj);
+    if (func->parameters.size() != arg_count) {
+        std::cerr << "Cantidad de argumentos incorrecta\n";
+        return nullptr;
+    }
+    return func;
+}
+
+bool check_builtin_arity(const Builtin& builtin, size_t arg_count) {
+    if (builtin.arity != arg_count) {
+        std::cerr << "Cantidad de argumentos incorrecta\n";
+        return false;
+    }
+    return true;
+}
+
+void report_stray_flow(Flow flow) {
+    std::cerr << (flow == Flow::BREAK ? "break" : "continue") << " fuera de un ciclo\n";
+}
+
+static bool integer_binding(std::shared_ptr<Object>* slot) {
+    return slot && *slot && (*slot)->type() == ObjectType::INTEGER_OBJ;
+}
+
+bool for_loop_start(ForStatement* loop, const std::shared_ptr<Environment>& env, ForLoopState& state) {
+    const CountedLoop& counted = loop->counted;
+    state.counter_slot = env->find_slot(counted.var);
+    if (!integer_binding(state.counter_slot)) return false;
+
+    if (auto limit_lit = dynamic_cast<IntegerLiteral*>(counted.limit)) {
+        state.limit = limit_lit->value;
+    } else {
+        state.limit_slot = env->find_slot(static_cast<Identifier*>(counted.limit)->value);
+        if (!integer_binding(state.limit_slot)) return false;
+        state.limit_value = *state.limit_slot;
+        state.limit = static_cast<Integer&>(*state.limit_value).value;
+    }
+
+    // El valor inicial puede venir de otra variable (let i = n): el contador
+    // necesita un Integer propio para poder modificarlo en el lugar
+    state.counter = *state.counter_slot;
+    if (state.counter.use_count() > 2) {
+        state.counter = std::make_shared<Integer>(static_cast<Integer&>(*state.counter).value);
+        *state.counter_slot = state.counter;
+    }
+    return true;
+}
+
+bool for_loop_continues(const ForStatement* loop, ForLoopState& state) {
+    // Alguien volvió a ligar o asignó el contador o el límite: se adopta el
+    // valor nuevo. Con algo que no es entero la comparación falla y el ciclo
+    // termina, como en el camino general.
+    if (state.counter_slot->get() != state.counter.get()) {
+        if (!integer_binding(state.counter_slot)) return false;
+        state.counter = *state.counter_slot;
+    }
+    if (state.limit_slot && state.limit_slot->get() != state.limit_value.get()) {
+        if (!integer_binding(state.limit_slot)) return false;
+        state.limit_value = *state.limit_slot;
+        state.limit = static_cast<Integer&>(*state.limit_value).value;
+    }
+
+    int value = static_cast<const Integer&>(*state.counter).value;
+    const std::string& cmp = loop->counted.cmp;
+    if (cmp == "<") return value < state.limit;
+    if (cmp == ">") return value > state.limit;
+    return value != state.limit;
+}
+
+void for_loop_advance(const ForStatement* loop, ForLoopState& state) {
+    if (state.counter_slot->get() != state.counter.get()) {
+        if (!integer_binding(state.counter_slot)) return;
+        state.counter = *state.counter_slot;
+    }
+    int next = static_cast<Integer&>(*state.counter).value + loop->counted.step;
+    // Solo el entorno y el ciclo lo ven: se actualiza sin asignar. Si el
+    // cuerpo se guardó el valor (let j = i, resultado del cuerpo) se crea otro.
+    if (state.counter.use_count() == 2) {
+        static_cast<Integer&>(*state.counter).value = next;
+    } else {
+        state.counter = std::make_shared<Integer>(next);
+        *state.counter_slot = state.counter;
+    }
+}
+
+// Aritmética entera sin efectos laterales, calculada sin crear objetos
+static bool eval_unboxed_int(Expression* node, const std::shared_ptr<Environment>& env, int& out) {
+    skip_numbered_value(node);
+    if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+        out = int_lit->value;
+        return true;
+    }
+    if (auto ident = dynamic_cast<Identifier*>(node)) {
+        auto slot = env->find_slot(ident->value);
+        if (!integer_binding(slot)) return false;
+        out = static_cast<Integer&>(**slot).value;
+        return true;
+    }
+    if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+        if (prefix->op != "-" || !eval_unboxed_int(prefix->right.get(), env, out)) return false;
+        out = -out;
+        return true;
+    }
+    if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+        int left, right;
+        if (!eval_unboxed_int(infix->left.get(), env, left) || !eval_unboxed_int(infix->right.get(), env, right)) {
+            return false;
+        }
+        if (infix->op == "+") out = left + right;
+        else if (infix->op == "-") out = left - right;
+        else if (infix->op == "*") out = left * right;
+        else if (infix->op == "/" && right != 0) out = left / right;
+        else return false;
+        return true;
+    }
+    return false;
+}
+
+std::shared_ptr<Object> assign_in_place(AssignExpression* assign, const std::shared_ptr<Environment>& env) {
+    auto slot = env->find_slot(assign->name);
+    // Otro dueño (una variable, un resultado guardado) ve el valor viejo
+    if (!integer_binding(slot) || slot->use_count() != 1) return nullptr;
+    int value;
+    if (!eval_unboxed_int(assign->value.get(), env, value)) return nullptr;
+    static_cast<Integer&>(**slot).value = value;
+    return *slot;
+}
+
+std::shared_ptr<Object> assign_binding(AssignExpression* assign, std::shared_ptr<Object> val,
+                                       const std::shared_ptr<Environment>& env) {
+    if (!val) return nullptr;
+    switch (env->assign(assign->name, val)) {
+        case AssignResult::ASSIGNED: return val;
+        case AssignResult::UNDEFINED:
+            std::cerr << "Asignación a identificador no definido: " << assign->name << "\n";
+            return nullptr;
+        case AssignResult::READ_ONLY:
+            std::cerr << "Asignación a " << assign->name << ", que es de un entorno compartido (solo lectura)\n";
+            return nullptr;
+    }
+    return nullptr;
+}
+
+// Evalúa node dejando en flow cómo terminó. Quien evalúa un hijo que puede
+// contener sentencias (bloques de if, cuerpos) debe cortar si flow dejó de
+// ser NORMAL y devolver el valor tal cual.
+static std::shared_ptr<Object> eval_node(Node* node, const std::shared_ptr<Environment>& env, Flow& flow);
 
 std::shared_ptr<Object> eval(std::unique_ptr<Node>& node, std::shared_ptr<Environment> env) {
     return eval(node.get(), env);
 }
 
 std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env) {
+    Flow flow = Flow::NORMAL;
+    return eval(node, env, flow);
+}
+
+std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env, Flow& flow) {
+    flow = Flow::NORMAL;
+    auto result = eval_node(node, env, flow);
+    if (flow == Flow::BREAK || flow == Flow::CONTINUE) {
+        report_stray_flow(flow);
+        return nullptr;
+    }
+    return result;
+}
+
+static std::shared_ptr<Object> eval_node(Node* node, const std::shared_ptr<Environment>& env, Flow& flow) {
+    AllocSiteScope site(node);
+
     if (auto program = dynamic_cast<Program*>(node)) {
         std::shared_ptr<Object> result;
         for (auto& stmt : program->statements) {
-            result = eval(stmt.get(), env);
-            if (result && result->type() == ObjectType::RETURN_VALUE_OBJ) {
-                return std::dynamic_pointer_cast<ReturnValue>(result)->value;
-            }
+            result = eval_node(stmt.get(), env, flow);
+            if (flow != Flow::NORMAL) break;
         }
         return result;
     }
@@ -22,16 +353,14 @@ std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env) {
     if (auto block = dynamic_cast<BlockStatement*>(node)) {
         std::shared_ptr<Object> result;
         for (auto& stmt : block->statements) {
-            result = eval(stmt.get(), env);
-            if (result && result->type() == ObjectType::RETURN_VALUE_OBJ) {
-                return result;
-            }
+            result = eval_node(stmt.get(), env, flow);
+            if (flow != Flow::NORMAL) break;
         }
         return result;
     }
 
     if (auto stmt = dynamic_cast<ExpressionStatement*>(node)) {
-        return eval(stmt->expression.get(), env);
+        return eval_node(stmt->expression.get(), env, flow);
     }
 
     if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
@@ -42,96 +371,74 @@ std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env) {
         return std::make_shared<Boolean>(bool_lit->value);
     }
 
+    if (auto str_lit = dynamic_cast<StringLiteral*>(node)) {
+        return str_lit->value;
+    }
+
     if (auto ident = dynamic_cast<Identifier*>(node)) {
-        auto val = env->get(ident->value);
-        if (val) return val;
-        std::cerr << "Identificador no definido: " << ident->value << "\n";
-        return nullptr;
+        return eval_identifier(ident, env);
     }
 
     if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
-        auto val = eval(let_stmt->value.get(), env);
-
-        if (val && val->type() == ObjectType::FUNCTION_OBJ) {
-            auto func = std::dynamic_pointer_cast<Function>(val);
-            auto func_env = std::make_shared<Environment>(func->env);
-            std::shared_ptr<Function> self_ref = std::make_shared<Function>(func->parameters, func->body, func_env);
-            func_env->set(let_stmt->name, self_ref);
-            val = self_ref;
-        }
+        auto val = eval_node(let_stmt->value.get(), env, flow);
+        if (flow != Flow::NORMAL) return val;
+        return bind_let(let_stmt, val, env);
+    }
 
-        if (val) {
-            env->set(let_stmt->name, val);
+    if (auto return_stmt = dynamic_cast<ReturnStatement*>(node)) {
+        std::shared_ptr<Object> val = std::make_shared<Null>();
+        if (return_stmt->value) {
+            val = eval_node(return_stmt->value.get(), env, flow);
+            if (flow != Flow::NORMAL) return val;
         }
+        flow = Flow::RETURN;
         return val;
     }
 
-    if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
-        auto right = eval(prefix->right.get(), env);
-        if (!right) return nullptr;
-
-        if (prefix->op == "!") {
-            if (right->type() == ObjectType::BOOLEAN_OBJ) {
-                return std::make_shared<Boolean>(!std::dynamic_pointer_cast<Boolean>(right)->value);
-            } else if (right->type() == ObjectType::NULL_OBJ) {
-                return std::make_shared<Boolean>(true);
-            } else {
-                return std::make_shared<Boolean>(false);
-            }
-        }
-        if (prefix->op == "-") {
-            if (right->type() == ObjectType::INTEGER_OBJ) {
-                return std::make_shared<Integer>(-std::dynamic_pointer_cast<Integer>(right)->value);
-            }
-        }
-        return nullptr;
+    if (auto assign = dynamic_cast<AssignExpression*>(node)) {
+        if (auto updated = assign_in_place(assign, env)) return updated;
+        auto val = eval_node(assign->value.get(), env, flow);
+        if (flow != Flow::NORMAL) return val;
+        return assign_binding(assign, val, env);
     }
 
-    if (auto infix = dynamic_cast<InfixExpression*>(node)) {
-        auto left = eval(infix->left.get(), env);
-        auto right = eval(infix->right.get(), env);
-        if (!left || !right) return nullptr;
-
-        if (left->type() == ObjectType::INTEGER_OBJ && right->type() == ObjectType::INTEGER_OBJ) {
-            int lval = std::dynamic_pointer_cast<Integer>(left)->value;
-            int rval = std::dynamic_pointer_cast<Integer>(right)->value;
-            if (infix->op == "+") return std::make_shared<Integer>(lval + rval);
-            if (infix->op == "-") return std::make_shared<Integer>(lval - rval);
-            if (infix->op == "*") return std::make_shared<Integer>(lval * rval);
-            if (infix->op == "/") return std::make_shared<Integer>(lval / rval);
-            if (infix->op == "==") return std::make_shared<Boolean>(lval == rval);
-            if (infix->op == "!=") return std::make_shared<Boolean>(lval != rval);
-            if (infix->op == "<") return std::make_shared<Boolean>(lval < rval);
-            if (infix->op == ">") return std::make_shared<Boolean>(lval > rval);
-        }
-
-        if (left->type() == ObjectType::BOOLEAN_OBJ && right->type() == ObjectType::BOOLEAN_OBJ) {
-            bool lval = std::dynamic_pointer_cast<Boolean>(left)->value;
-            bool rval = std::dynamic_pointer_cast<Boolean>(right)->value;
-            if (infix->op == "==") return std::make_shared<Boolean>(lval == rval);
-            if (infix->op == "!=") return std::make_shared<Boolean>(lval != rval);
-        }
+    if (dynamic_cast<BreakStatement*>(node)) {
+        flow = Flow::BREAK;
+        return nullptr;
+    }
 
+    if (dynamic_cast<ContinueStatement*>(node)) {
+        flow = Flow::CONTINUE;
         return nullptr;
     }
 
+    if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+        std::shared_ptr<Object> reused;
+        if (reuse_numbered_value(prefix, reused)) return reused;
+        auto right = eval_node(prefix->right.get(), env, flow);
+        if (flow != Flow::NORMAL) return right;
+        return define_numbered_value(prefix, eval_prefix_expression(prefix, right));
+    }
+
+    if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+        std::shared_ptr<Object> reused;
+        if (reuse_numbered_value(infix, reused)) return reused;
+        auto left = eval_node(infix->left.get(), env, flow);
+        if (flow != Flow::NORMAL) return left;
+        auto right = eval_node(infix->right.get(), env, flow);
+        if (flow != Flow::NORMAL) return right;
+        return define_numbered_value(infix, eval_infix_expression(infix, left, right));
+    }
+
     if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
-        auto condition = eval(if_expr->condition.get(), env);
+        auto condition = eval_node(if_expr->condition.get(), env, flow);
+        if (flow != Flow::NORMAL) return condition;
         if (!condition) return nullptr;
 
-        bool cond = false;
-        if (condition->type() == ObjectType::BOOLEAN_OBJ) {
-            cond = std::dynamic_pointer_cast<Boolean>(condition)->value;
-        } else if (condition->type() == ObjectType::NULL_OBJ) {
-            cond = false;
-        } else {
-            cond = true;
-        }
-
-        if (cond) {
-            return eval(if_expr->consequence.get(), env);
+        if (is_truthy(if_expr->condition.get(), condition)) {
+            return eval_node(if_expr->consequence.get(), env, flow);
         } else if (if_expr->alternative) {
-            return eval(if_expr->alternative.get(), env);
+            return eval_node(if_expr->alternative.get(), env, flow);
         } else {
             return std::make_shared<Null>();
         }
@@ -139,44 +446,127 @@ std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env) {
 
     if (auto while_stmt = dynamic_cast<WhileStatement*>(node)) {
         std::shared_ptr<Object> result;
+        int iterations = 0;
         while (true) {
-            auto cond = eval(while_stmt->condition.get(), env);
-            if (!cond || (cond->type() == ObjectType::BOOLEAN_OBJ && !std::dynamic_pointer_cast<Boolean>(cond)->value)) {
+            auto cond = eval_node(while_stmt->condition.get(), env, flow);
+            if (flow != Flow::NORMAL) return cond;
+            if (!loop_continues(while_stmt->condition.get(), cond)) {
+                break;
+            }
+            auto body_result = eval_node(while_stmt->body.get(), env, flow);
+            if (flow == Flow::RETURN) return body_result;
+            if (flow == Flow::BREAK) {
+                flow = Flow::NORMAL;
+                break;
+            }
+            if (flow == Flow::CONTINUE) {
+                flow = Flow::NORMAL;
+            } else {
+                result = std::move(body_result);
+            }
+
+            // Contador de vueltas: un loop largo pasa al nivel optimizado a mitad de camino
+            if (++iterations == LOOP_TIER_THRESHOLD && run_loop_tier(while_stmt, env, result)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    if (auto for_stmt = dynamic_cast<ForStatement*>(node)) {
+        if (for_stmt->init) {
+            auto init = eval_node(for_stmt->init.get(), env, flow);
+            if (flow != Flow::NORMAL) return init;
+        }
+
+        std::shared_ptr<Object> result;
+        ForLoopState state;
+        int iterations = 0;
+        bool counted = for_stmt->counted.valid && for_loop_start(for_stmt, env, state);
+        while (true) {
+            if (counted) {
+                if (!for_loop_continues(for_stmt, state)) break;
+            } else if (for_stmt->condition) {
+                auto cond = eval_node(for_stmt->condition.get(), env, flow);
+                if (flow != Flow::NORMAL) return cond;
+                if (!loop_continues(for_stmt->condition.get(), cond)) break;
+            }
+
+            auto body_result = eval_node(for_stmt->body.get(), env, flow);
+            if (flow == Flow::RETURN) return body_result;
+            if (flow == Flow::BREAK) {
+                flow = Flow::NORMAL;
+                break;
+            }
+            if (flow == Flow::CONTINUE) {
+                flow = Flow::NORMAL;
+            } else {
+                result = std::move(body_result);
+            }
+
+            if (counted) {
+                for_loop_advance(for_stmt, state);
+            } else if (for_stmt->update) {
+                auto update = eval_node(for_stmt->update.get(), env, flow);
+                if (flow != Flow::NORMAL) return update;
+            }
+
+            if (++iterations == LOOP_TIER_THRESHOLD && run_loop_tier(for_stmt, env, result)) {
                 break;
             }
-            result = eval(while_stmt->body.get(), env);
         }
         return result;
     }
 
     if (auto func = dynamic_cast<FunctionLiteral*>(node)) {
-        return std::make_shared<Function>(func->parameters, func->body, env);
+        return make_closure(func, env);
     }
 
     if (auto call = dynamic_cast<CallExpression*>(node)) {
-        auto func_obj = eval(call->function.get(), env);
-        if (!func_obj || func_obj->type() != ObjectType::FUNCTION_OBJ) {
-            std::cerr << "Llamando a algo que no es funcion\n";
-            return nullptr;
+        auto callee = eval_node(call->function.get(), env, flow);
+        if (flow != Flow::NORMAL) return callee;
+        auto inlined = dynamic_cast<InlinedCall*>(call);
+        if (inlined && inline_target(*inlined, callee)) {
+            InlineArguments args;
+            for (size_t i = 0; i < call->arguments.size(); ++i) {
+                args[i] = eval_node(call->arguments[i].get(), env, flow);
+                if (flow != Flow::NORMAL) return args[i];
+                if (!args[i]) return nullptr;
+            }
+            return eval_inlined_call(*inlined, static_cast<Function&>(*callee), args.data());
         }
-
-        auto func = std::dynamic_pointer_cast<Function>(func_obj);
-        if (func->parameters.size() != call->arguments.size()) {
-            std::cerr << "Cantidad de argumentos incorrecta\n";
-            return nullptr;
+        if (callee && callee->type() == ObjectType::BUILTIN_OBJ) {
+            auto builtin = std::static_pointer_cast<Builtin>(callee);
+            if (!check_builtin_arity(*builtin, call->arguments.size())) return nullptr;
+            std::vector<std::shared_ptr<Object>> args;
+            for (auto& arg : call->arguments) {
+                auto arg_val = eval_node(arg.get(), env, flow);
+                if (flow != Flow::NORMAL) return arg_val;
+                if (!arg_val) return nullptr;
+                args.push_back(arg_val);
+            }
+            return call_builtin_blocking(*builtin, args);
         }
 
-        auto extended_env = std::make_shared<Environment>(func->env);
+        auto func = check_callable(callee, call->arguments.size());
+        if (!func || !ensure_parsed(*func->body)) return nullptr;
+
+        CallFrame frame(func->env, func->body->frame_escapes);
+        const auto& extended_env = frame.env();
         for (size_t i = 0; i < func->parameters.size(); ++i) {
-            auto arg_val = eval(call->arguments[i].get(), env);
+            auto arg_val = eval_node(call->arguments[i].get(), env, flow);
+            if (flow != Flow::NORMAL) return arg_val;
             if (!arg_val) return nullptr;
             extended_env->set(func->parameters[i], arg_val);
         }
 
-        auto result = eval(func->body.get(), extended_env);
-        if (result && result->type() == ObjectType::RETURN_VALUE_OBJ) {
-            return std::dynamic_pointer_cast<ReturnValue>(result)->value;
+        // El return termina acá; break/continue no pueden salir de la función
+        auto result = eval_node(func->body.get(), extended_env, flow);
+        if (flow == Flow::BREAK || flow == Flow::CONTINUE) {
+            report_stray_flow(flow);
+            result = nullptr;
         }
+        flow = Flow::NORMAL;
         return result;
     }
 
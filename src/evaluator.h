@@ -6,10 +6,68 @@
 #include "object.h"
 #include "environment.h"
 
+// Estado de control que acompaña al valor: return, break y continue se
+// propagan hacia arriba sin envolver el valor en un objeto
+enum class Flow {
+    NORMAL,
+    RETURN,     // el valor es el resultado de la función (o del programa)
+    BREAK,
+    CONTINUE,
+};
+
 // Eval para nodos como unique_ptr<Node>
 std::shared_ptr<Object> eval(std::unique_ptr<Node>& node, std::shared_ptr<Environment> env);
 
 // Eval para punteros crudos Node*
 std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env);
 
+// Igual, pero informa en flow si la evaluación terminó con un return (por
+// ejemplo una sentencia de nivel superior ejecutada sola, ver --stream)
+std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env, Flow& flow);
+
+// Semántica compartida por el evaluador recursivo y el evaluador sin pila
+std::shared_ptr<Object> eval_identifier(Identifier* ident, const std::shared_ptr<Environment>& env);
+std::shared_ptr<Object> bind_let(LetStatement* let_stmt, std::shared_ptr<Object> val,
+                                 const std::shared_ptr<Environment>& env);
+std::shared_ptr<Object> eval_prefix_expression(const std::string& op, const std::shared_ptr<Object>& right);
+std::shared_ptr<Object> eval_infix_expression(const std::string& op, const std::shared_ptr<Object>& left,
+                                              const std::shared_ptr<Object>& right);
+bool is_truthy(const std::shared_ptr<Object>& condition);
+bool loop_continues(const std::shared_ptr<Object>& cond);
+// Igual, pero sin chequeos de tipo donde infer_types marcó los operandos
+std::shared_ptr<Object> eval_prefix_expression(const PrefixExpression* prefix, const std::shared_ptr<Object>& right);
+std::shared_ptr<Object> eval_infix_expression(const InfixExpression* infix, const std::shared_ptr<Object>& left,
+                                              const std::shared_ptr<Object>& right);
+bool is_truthy(const Expression* condition_node, const std::shared_ptr<Object>& condition);
+bool loop_continues(const Expression* condition_node, const std::shared_ptr<Object>& cond);
+// nullptr (con el error reportado) si no es una función con esa cantidad de parámetros
+std::shared_ptr<Function> check_callable(const std::shared_ptr<Object>& func_obj, size_t arg_count);
+bool check_builtin_arity(const Builtin& builtin, size_t arg_count);
+// break/continue que llegan al borde de una función o del programa
+void report_stray_flow(Flow flow);
+
+// for contado (loop->counted): el contador se lleva sin eval() por vuelta.
+// Se guardan las ligaduras del contador y del límite para notar si el
+// cuerpo (o una clausura) las cambia.
+struct ForLoopState {
+    std::shared_ptr<Object> counter;
+    std::shared_ptr<Object>* counter_slot = nullptr;
+    std::shared_ptr<Object> limit_value;              // nullptr si el límite es literal
+    std::shared_ptr<Object>* limit_slot = nullptr;
+    int limit = 0;
+};
+
+// Se llama después del init; false si los valores no son enteros y hay que
+// usar el camino general.
+bool for_loop_start(ForStatement* loop, const std::shared_ptr<Environment>& env, ForLoopState& state);
+bool for_loop_continues(const ForStatement* loop, ForLoopState& state);
+void for_loop_advance(const ForStatement* loop, ForLoopState& state);
+
+// x = valor. assign_in_place actualiza sin asignar memoria un entero que
+// solo el entorno ve, si el valor se puede calcular sin boxing; si no,
+// devuelve nullptr y hay que evaluar el valor y llamar a assign_binding.
+std::shared_ptr<Object> assign_in_place(AssignExpression* assign, const std::shared_ptr<Environment>& env);
+std::shared_ptr<Object> assign_binding(AssignExpression* assign, std::shared_ptr<Object> val,
+                                       const std::shared_ptr<Environment>& env);
+
 #endif // EVALUATOR_H
\ No newline at end of file
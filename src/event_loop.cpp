@@ -0,0 +1,145 @@
+#include "event_loop.h"
+#include "stackless_evaluator.h"
+
+namespace {
+
+// co_await sobre una llamada a builtin: la operación avisa por la
+// completion y el loop retoma la corrutina en su hilo.
+struct HostCall {
+    EventLoop& loop;
+    const Builtin& builtin;
+    std::vector<std::shared_ptr<Object>>& args;
+    std::shared_ptr<Object> value;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        builtin.fn(loop, args, [this, handle](std::shared_ptr<Object> result) {
+            value = std::move(result);
+            // Nunca se retoma en línea: la completion puede llegar desde
+            // dentro de fn o desde otro hilo
+            loop.post([handle]() { handle.resume(); });
+        });
+    }
+
+    std::shared_ptr<Object> await_resume() { return std::move(value); }
+};
+
+ScriptTask run_script(EventLoop& loop, std::shared_ptr<Node> program, std::shared_ptr<Environment> env) {
+    StacklessEvaluator evaluator;
+    evaluator.start(program.get(), std::move(env));
+    while (true) {
+        switch (evaluator.run()) {
+            case StacklessEvaluator::Status::DONE:
+                co_return evaluator.result();
+            case StacklessEvaluator::Status::FAILED:
+                co_return nullptr;
+            case StacklessEvaluator::Status::SUSPENDED:
+                evaluator.resume(co_await HostCall{loop, evaluator.pending_builtin(), evaluator.pending_args(), {}});
+                break;
+        }
+    }
+}
+
+} // namespace
+
+void ScriptTask::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    handle.promise().loop->finished.push_back(handle.address());
+}
+
+EventLoop::EventLoop(size_t blocking_threads) {
+    for (size_t i = 0; i < blocking_threads; ++i) {
+        workers.emplace_back([this]() { worker_main(); });
+    }
+}
+
+EventLoop::~EventLoop() {
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void EventLoop::spawn(std::shared_ptr<Node> program, std::shared_ptr<Environment> env, ScriptCallback on_done) {
+    auto script = std::make_unique<Script>(Script{run_script(*this, std::move(program), std::move(env)),
+                                                  std::move(on_done)});
+    auto handle = script->task.handle;
+    handle.promise().loop = this;
+    scripts.emplace(handle.address(), std::move(script));
+    post([handle]() { handle.resume(); });
+}
+
+void EventLoop::post(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(std::move(fn));
+    }
+    wakeup.notify_one();
+}
+
+void EventLoop::after(std::chrono::milliseconds delay, std::function<void()> fn) {
+    // Solo se llama desde el hilo del loop (dentro de un builtin)
+    timers.push(Timer{Clock::now() + delay, timer_sequence++, std::move(fn)});
+}
+
+void EventLoop::run_blocking(std::function<std::shared_ptr<Object>()> work, HostCompletion done) {
+    {
+        std::lock_guard<std::mutex> lock(work_mutex);
+        work_queue.push_back([work = std::move(work), done = std::move(done)]() { done(work()); });
+    }
+    work_available.notify_one();
+}
+
+void EventLoop::worker_main() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(work_mutex);
+            work_available.wait(lock, [this]() { return stopping || !work_queue.empty(); });
+            if (work_queue.empty()) return;
+            job = std::move(work_queue.front());
+            work_queue.pop_front();
+        }
+        job();
+    }
+}
+
+void EventLoop::run() {
+    while (!scripts.empty()) {
+        std::deque<std::function<void()>> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (ready.empty()) {
+                if (timers.empty()) {
+                    wakeup.wait(lock, [this]() { return !ready.empty(); });
+                } else {
+                    wakeup.wait_until(lock, timers.top().deadline, [this]() { return !ready.empty(); });
+                }
+            }
+            batch.swap(ready);
+        }
+
+        for (auto& fn : batch) {
+            fn();
+        }
+
+        auto now = Clock::now();
+        while (!timers.empty() && timers.top().deadline <= now) {
+            auto fn = timers.top().fn;
+            timers.pop();
+            fn();
+        }
+
+        // Entregar los resultados de los scripts que terminaron
+        for (void* address : finished) {
+            auto node = scripts.extract(address);
+            Script& script = *node.mapped();
+            script.on_done(script.task.handle.promise().result);
+        }
+        finished.clear();
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast.h"
+#include "builtins.h"
+#include "environment.h"
+
+class EventLoop;
+
+// Corrutina que ejecuta un script. Arranca suspendida; el EventLoop la
+// retoma cada vez que la operación del host que esperaba se completa.
+class ScriptTask {
+public:
+    struct promise_type;
+
+    // Al terminar, el script se anota en su loop para entregar el resultado
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        std::shared_ptr<Object> result;
+        EventLoop* loop = nullptr;
+
+        ScriptTask get_return_object() {
+            return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(std::shared_ptr<Object> value) { result = std::move(value); }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit ScriptTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    ScriptTask(ScriptTask&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    ScriptTask(const ScriptTask&) = delete;
+    ScriptTask& operator=(const ScriptTask&) = delete;
+    ~ScriptTask() {
+        if (handle) handle.destroy();
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Loop de eventos de un solo hilo que multiplexa muchos scripts suspendidos.
+// Los timers se atienden en el propio hilo y el trabajo bloqueante va a un
+// pool chico de hilos auxiliares; ninguna espera bloquea al hilo del loop.
+class EventLoop : public HostContext {
+public:
+    using ScriptCallback = std::function<void(std::shared_ptr<Object>)>;
+
+    explicit EventLoop(size_t blocking_threads = 4);
+    ~EventLoop() override;
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Agenda un script (normalmente un Program); on_done recibe su resultado
+    // en el hilo del loop.
+    void spawn(std::shared_ptr<Node> program, std::shared_ptr<Environment> env, ScriptCallback on_done);
+
+    // Corre hasta que terminen todos los scripts
+    void run();
+
+    // Encola fn para ejecutarse en el hilo del loop (seguro desde cualquier hilo)
+    void post(std::function<void()> fn);
+
+    void after(std::chrono::milliseconds delay, std::function<void()> fn) override;
+    void run_blocking(std::function<std::shared_ptr<Object>()> work, HostCompletion done) override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t sequence;   // desempate: mismo deadline, orden de llegada
+        std::function<void()> fn;
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    struct Script {
+        ScriptTask task;
+        ScriptCallback on_done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<std::function<void()>> ready;
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timer_sequence = 0;
+
+    std::unordered_map<void*, std::unique_ptr<Script>> scripts;   // por dirección de la corrutina
+    std::vector<void*> finished;
+
+    friend struct ScriptTask::FinalAwaiter;
+
+    // Pool para run_blocking
+    std::mutex work_mutex;
+    std::condition_variable work_available;
+    std::deque<std::function<void()>> work_queue;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    void worker_main();
+};
+
+#endif // EVENT_LOOP_H
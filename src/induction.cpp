@@ -0,0 +1,113 @@
+#include "induction.h"
+
+bool rebinds_name(const Node* node, const std::string& name) {
+    if (!node) return false;
+
+    if (auto let_stmt = dynamic_cast<const LetStatement*>(node)) {
+        return let_stmt->name == name || rebinds_name(let_stmt->value.get(), name);
+    }
+
+    if (auto assign = dynamic_cast<const AssignExpression*>(node)) {
+        return assign->name == name || rebinds_name(assign->value.get(), name);
+    }
+
+    if (auto block = dynamic_cast<const BlockStatement*>(node)) {
+        for (const auto& stmt : block->statements) {
+            if (rebinds_name(stmt.get(), name)) return true;
+        }
+        return false;
+    }
+
+    if (auto stmt = dynamic_cast<const ExpressionStatement*>(node)) {
+        return rebinds_name(stmt->expression.get(), name);
+    }
+
+    if (auto return_stmt = dynamic_cast<const ReturnStatement*>(node)) {
+        return rebinds_name(return_stmt->value.get(), name);
+    }
+
+    if (auto while_stmt = dynamic_cast<const WhileStatement*>(node)) {
+        return rebinds_name(while_stmt->condition.get(), name) ||
+               rebinds_name(while_stmt->body.get(), name);
+    }
+
+    if (auto for_stmt = dynamic_cast<const ForStatement*>(node)) {
+        return rebinds_name(for_stmt->init.get(), name) ||
+               rebinds_name(for_stmt->condition.get(), name) ||
+               rebinds_name(for_stmt->update.get(), name) ||
+               rebinds_name(for_stmt->body.get(), name);
+    }
+
+    if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        return rebinds_name(prefix->right.get(), name);
+    }
+
+    if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        return rebinds_name(infix->left.get(), name) || rebinds_name(infix->right.get(), name);
+    }
+
+    if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+        return rebinds_name(if_expr->condition.get(), name) ||
+               rebinds_name(if_expr->consequence.get(), name) ||
+               rebinds_name(if_expr->alternative.get(), name);
+    }
+
+    if (auto call = dynamic_cast<const CallExpression*>(node)) {
+        if (rebinds_name(call->function.get(), name)) return true;
+        for (const auto& arg : call->arguments) {
+            if (rebinds_name(arg.get(), name)) return true;
+        }
+        return false;
+    }
+
+    // Las funciones anidadas ligan en su propio marco
+    return false;
+}
+
+static bool is_identifier(const Node* node, const std::string& name) {
+    auto ident = dynamic_cast<const Identifier*>(node);
+    return ident && ident->value == name;
+}
+
+CountedLoop analyze_counted_loop(const ForStatement* loop) {
+    CountedLoop counted;
+
+    auto init = dynamic_cast<const LetStatement*>(loop->init.get());
+    if (!init) return counted;
+    const std::string& var = init->name;
+
+    // i < limite, i > limite o i != limite
+    auto cond = dynamic_cast<const InfixExpression*>(loop->condition.get());
+    if (!cond || !is_identifier(cond->left.get(), var)) return counted;
+    if (cond->op != "<" && cond->op != ">" && cond->op != "!=") return counted;
+    Expression* limit = cond->right.get();
+    if (auto limit_ident = dynamic_cast<const Identifier*>(limit)) {
+        if (limit_ident->value == var || rebinds_name(loop->body.get(), limit_ident->value)) return counted;
+    } else if (!dynamic_cast<const IntegerLiteral*>(limit)) {
+        return counted;
+    }
+
+    // let i = i ± paso o i = i ± paso
+    const Expression* update_value = nullptr;
+    if (auto update = dynamic_cast<const LetStatement*>(loop->update.get())) {
+        if (update->name == var) update_value = update->value.get();
+    } else if (auto update = dynamic_cast<const ExpressionStatement*>(loop->update.get())) {
+        auto assign = dynamic_cast<const AssignExpression*>(update->expression.get());
+        if (assign && assign->name == var) update_value = assign->value.get();
+    }
+    auto step = dynamic_cast<const InfixExpression*>(update_value);
+    if (!step || !is_identifier(step->left.get(), var) || (step->op != "+" && step->op != "-")) return counted;
+    auto step_lit = dynamic_cast<const IntegerLiteral*>(step->right.get());
+    if (!step_lit) return counted;
+
+    // Si el cuerpo mueve el contador a la vista no vale la pena: el camino
+    // rápido lo detectaría en cada vuelta (ver for_loop_continues)
+    if (rebinds_name(loop->body.get(), var)) return counted;
+
+    counted.valid = true;
+    counted.var = var;
+    counted.cmp = cond->op;
+    counted.step = step->op == "+" ? step_lit->value : -step_lit->value;
+    counted.limit = limit;
+    return counted;
+}
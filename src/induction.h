@@ -0,0 +1,17 @@
+#ifndef INDUCTION_H
+#define INDUCTION_H
+
+#include <string>
+#include "ast.h"
+
+// Reconoce la variable de inducción de un for contado. Si el for tiene esa
+// forma, el evaluador lleva el contador sin pasar por eval() en cada vuelta
+// (ver for_loop_* en evaluator.h).
+CountedLoop analyze_counted_loop(const ForStatement* loop);
+
+// true si node vuelve a ligar o asigna name a la vista: un let o una
+// asignación fuera de funciones anidadas. Las clausuras pueden asignarlo
+// igual, así que no reemplaza a un chequeo en ejecución.
+bool rebinds_name(const Node* node, const std::string& name);
+
+#endif // INDUCTION_H
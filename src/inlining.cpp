@@ -0,0 +1,222 @@
+#include "inlining.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "evaluator.h"
+#include "value_numbering.h"
+
+namespace {
+
+// Expresión que da el valor de un bloque de una sola sentencia, o nullptr.
+// Un return en el cuerpo (o en una rama de su if) da el valor de la función
+// igual que la expresión suelta.
+Expression* single_value(const BlockStatement* block) {
+    if (!block || block->lazy || block->statements.size() != 1) return nullptr;
+    Statement* stmt = block->statements[0].get();
+    if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(stmt)) return expr_stmt->expression.get();
+    if (auto return_stmt = dynamic_cast<ReturnStatement*>(stmt)) return return_stmt->value.get();
+    return nullptr;
+}
+
+bool inlinable(const Expression* node, size_t& nodes) {
+    if (!node || ++nodes > MAX_INLINE_NODES) return false;
+    if (dynamic_cast<const IntegerLiteral*>(node) || dynamic_cast<const BooleanLiteral*>(node) ||
+        dynamic_cast<const Identifier*>(node)) {
+        return true;
+    }
+    if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        return inlinable(prefix->right.get(), nodes);
+    }
+    if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        return inlinable(infix->left.get(), nodes) && inlinable(infix->right.get(), nodes);
+    }
+    if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+        return inlinable(if_expr->condition.get(), nodes) &&
+               inlinable(single_value(if_expr->consequence.get()), nodes) &&
+               (!if_expr->alternative || inlinable(single_value(if_expr->alternative.get()), nodes));
+    }
+    return false;
+}
+
+// Función que se puede evaluar en línea. Sin body: el nombre está ligado a
+// otra cosa y tapa a los de afuera.
+struct Candidate {
+    std::shared_ptr<BlockStatement> body;
+    Expression* value = nullptr;
+    size_t parameters = 0;
+};
+
+Candidate make_candidate(const std::vector<std::string>& parameters, const std::shared_ptr<BlockStatement>& body) {
+    if (parameters.size() > MAX_INLINE_PARAMETERS) return {};
+    Expression* value = single_value(body.get());
+    size_t nodes = 0;
+    if (!inlinable(value, nodes)) return {};
+    return Candidate{body, value, parameters.size()};
+}
+
+class Inliner {
+public:
+    explicit Inliner(const std::shared_ptr<Environment>& env) : env(env) { scopes.emplace_back(); }
+
+    void run(Node* node) {
+        if (auto program = dynamic_cast<Program*>(node)) {
+            for (auto& stmt : program->statements) statement(stmt.get());
+        } else if (auto stmt = dynamic_cast<Statement*>(node)) {
+            statement(stmt);
+        }
+    }
+
+private:
+    const std::shared_ptr<Environment>& env;
+    // Un mapa por función: los let de los bloques ligan en el marco de la función
+    std::vector<std::unordered_map<std::string, Candidate>> scopes;
+    // Lo que se buscó en env
+    std::unordered_map<std::string, Candidate> globals;
+
+    const Candidate* lookup(const std::string& name) {
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            auto it = scope->find(name);
+            if (it != scope->end()) return &it->second;
+        }
+        if (!env) return nullptr;
+        auto [it, inserted] = globals.try_emplace(name);
+        if (inserted) {
+            auto value = env->get(name);
+            if (value && value->type() == ObjectType::FUNCTION_OBJ) {
+                auto& func = static_cast<Function&>(*value);
+                it->second = make_candidate(func.parameters, func.body);
+            }
+        }
+        return &it->second;
+    }
+
+    void statement(Statement* node) {
+        if (!node) return;
+        if (auto block = dynamic_cast<BlockStatement*>(node)) {
+            for (auto& stmt : block->statements) statement(stmt.get());
+        } else if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(node)) {
+            expression(expr_stmt->expression);
+        } else if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
+            expression(let_stmt->value);
+            auto func = dynamic_cast<FunctionLiteral*>(let_stmt->value.get());
+            scopes.back()[let_stmt->name] = func ? make_candidate(func->parameters, func->body) : Candidate{};
+        } else if (auto return_stmt = dynamic_cast<ReturnStatement*>(node)) {
+            expression(return_stmt->value);
+        } else if (auto while_stmt = dynamic_cast<WhileStatement*>(node)) {
+            expression(while_stmt->condition);
+            statement(while_stmt->body.get());
+        } else if (auto for_stmt = dynamic_cast<ForStatement*>(node)) {
+            statement(for_stmt->init.get());
+            expression(for_stmt->condition);
+            statement(for_stmt->update.get());
+            statement(for_stmt->body.get());
+        }
+    }
+
+    void expression(std::unique_ptr<Expression>& slot) {
+        Expression* node = slot.get();
+        if (!node) return;
+        if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+            expression(prefix->right);
+        } else if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+            expression(infix->left);
+            expression(infix->right);
+        } else if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
+            expression(if_expr->condition);
+            statement(if_expr->consequence.get());
+            statement(if_expr->alternative.get());
+        } else if (auto assign = dynamic_cast<AssignExpression*>(node)) {
+            expression(assign->value);
+            // Después de asignarla ya no es la función del let: la guarda fallaría siempre
+            for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+                auto it = scope->find(assign->name);
+                if (it == scope->end()) continue;
+                it->second = Candidate{};
+                break;
+            }
+        } else if (auto func = dynamic_cast<FunctionLiteral*>(node)) {
+            if (!func->body || func->body->lazy) return;
+            auto& scope = scopes.emplace_back();
+            for (const auto& param : func->parameters) scope[param] = Candidate{};
+            statement(func->body.get());
+            scopes.pop_back();
+        } else if (auto call = dynamic_cast<CallExpression*>(node)) {
+            expression(call->function);
+            for (auto& arg : call->arguments) expression(arg);
+            if (dynamic_cast<InlinedCall*>(call)) return;
+            auto callee = dynamic_cast<Identifier*>(call->function.get());
+            const Candidate* candidate = callee ? lookup(callee->value) : nullptr;
+            if (!candidate || !candidate->body || candidate->parameters != call->arguments.size()) return;
+
+            auto inlined = std::make_unique<InlinedCall>(call->token, std::move(call->function), candidate->body,
+                                                         candidate->value);
+            inlined->arguments = std::move(call->arguments);
+            inlined->line = call->line;
+            inlined->column = call->column;
+            inlined->static_type = call->static_type;
+            profile_allocation_at(inlined.get(), typeid(InlinedCall), sizeof(InlinedCall), inlined->line,
+                                  inlined->column);
+            slot = std::move(inlined);
+        }
+    }
+};
+
+// Misma semántica que eval_node sobre el cuerpo, con los parámetros tomados
+// de args. La expresión es chica y sin llamadas: la recursión está acotada.
+std::shared_ptr<Object> eval_inlined(Expression* node, const Function& func, const std::shared_ptr<Object>* args) {
+    AllocSiteScope site(node);
+
+    if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+        return std::make_shared<Integer>(int_lit->value);
+    }
+
+    if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
+        return std::make_shared<Boolean>(bool_lit->value);
+    }
+
+    if (auto ident = dynamic_cast<Identifier*>(node)) {
+        // Con parámetros repetidos gana el último, como al ligarlos en el marco
+        for (size_t i = func.parameters.size(); i-- > 0;) {
+            if (func.parameters[i] == ident->value) return args[i];
+        }
+        return eval_identifier(ident, func.env);
+    }
+
+    if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+        std::shared_ptr<Object> reused;
+        if (reuse_numbered_value(prefix, reused)) return reused;
+        auto right = eval_inlined(prefix->right.get(), func, args);
+        return define_numbered_value(prefix, eval_prefix_expression(prefix, right));
+    }
+
+    if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+        std::shared_ptr<Object> reused;
+        if (reuse_numbered_value(infix, reused)) return reused;
+        auto left = eval_inlined(infix->left.get(), func, args);
+        auto right = eval_inlined(infix->right.get(), func, args);
+        return define_numbered_value(infix, eval_infix_expression(infix, left, right));
+    }
+
+    auto if_expr = static_cast<IfExpression*>(node);
+    auto condition = eval_inlined(if_expr->condition.get(), func, args);
+    if (!condition) return nullptr;
+    if (is_truthy(if_expr->condition.get(), condition)) {
+        return eval_inlined(single_value(if_expr->consequence.get()), func, args);
+    }
+    if (if_expr->alternative) {
+        return eval_inlined(single_value(if_expr->alternative.get()), func, args);
+    }
+    return std::make_shared<Null>();
+}
+
+} // namespace
+
+void inline_calls(Node* node, const std::shared_ptr<Environment>& env) {
+    Inliner inliner(env);
+    inliner.run(node);
+}
+
+std::shared_ptr<Object> eval_inlined_call(const InlinedCall& call, const Function& func,
+                                          const std::shared_ptr<Object>* args) {
+    return eval_inlined(call.value, func, args);
+}
@@ -0,0 +1,42 @@
+#ifndef INLINING_H
+#define INLINING_H
+
+#include <array>
+#include <memory>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+
+// Inlining de funciones chicas. Una llamada f(a, b) donde f está ligada a
+// una función cuyo cuerpo es una sola expresión sin llamadas (operadores,
+// literales, variables e ifs de una expresión por rama) se reemplaza por un
+// InlinedCall. Sin llamadas en el cuerpo no hay recursión, y sin literales
+// de función ninguna clausura captura el marco, así que no hace falta crearlo:
+// los parámetros se leen de los argumentos y las variables libres del
+// entorno de la función, como en la llamada común.
+//
+// f se resuelve por los let a la vista (dentro de node, sin mirar el flujo)
+// o, si no hay ninguno, por su valor actual en env. Como f puede cambiar
+// después, la ejecución compara el cuerpo de la función llamada con el
+// esperado y, si no coincide, hace la llamada común: los errores y el orden
+// de evaluación son los mismos.
+//
+// Los cuerpos diferidos (ver LazyBody) no se miran.
+void inline_calls(Node* node, const std::shared_ptr<Environment>& env);
+
+inline constexpr size_t MAX_INLINE_NODES = 16;
+inline constexpr size_t MAX_INLINE_PARAMETERS = 4;
+
+using InlineArguments = std::array<std::shared_ptr<Object>, MAX_INLINE_PARAMETERS>;
+
+// callee es la función que espera call (si no, hay que llamarla como siempre)
+inline bool inline_target(const InlinedCall& call, const std::shared_ptr<Object>& callee) {
+    return callee && callee->type() == ObjectType::FUNCTION_OBJ &&
+           static_cast<const Function&>(*callee).body == call.body;
+}
+
+// Valor de la llamada con los argumentos ya evaluados (todos no nulos)
+std::shared_ptr<Object> eval_inlined_call(const InlinedCall& call, const Function& func,
+                                          const std::shared_ptr<Object>* args);
+
+#endif // INLINING_H
@@ -1,12 +1,192 @@
 #include "lexer.h"
-#include <cctype> // Para std::isspace, std::isdigit, std::isalpha
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 
-Lexer::Lexer(const std::string& src)
-    : source(src), character(0), read_position(0), position(0) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEXER_HAS_X86_SIMD 1
+#endif
+
+// Clases de caracteres (ASCII, independientes del locale)
+static constexpr unsigned char CLASS_SPACE = 1;
+static constexpr unsigned char CLASS_DIGIT = 2;
+static constexpr unsigned char CLASS_IDENT = 4; // letras, dígitos y '_'
+
+static constexpr auto char_classes = [] {
+    std::array<unsigned char, 256> table{};
+    for (int c : {' ', '\t', '\n', '\v', '\f', '\r'}) table[c] = CLASS_SPACE;
+    for (int c = '0'; c <= '9'; ++c) table[c] = CLASS_DIGIT | CLASS_IDENT;
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = CLASS_IDENT;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = CLASS_IDENT;
+    table['_'] = CLASS_IDENT;
+    return table;
+}();
+
+// Tokens de un solo carácter; el resto queda ILLEGAL
+static constexpr auto single_char_tokens = [] {
+    std::array<TokenType, 256> table{};
+    table['+'] = TokenType::PLUS;
+    table['-'] = TokenType::MINUS;
+    table['*'] = TokenType::ASTERISK;
+    table['/'] = TokenType::SLASH;
+    table['<'] = TokenType::LT;
+    table['>'] = TokenType::GT;
+    table[';'] = TokenType::SEMICOLON;
+    table[','] = TokenType::COMMA;
+    table['('] = TokenType::LPAREN;
+    table[')'] = TokenType::RPAREN;
+    table['{'] = TokenType::LBRACE;
+    table['}'] = TokenType::RBRACE;
+    return table;
+}();
+
+static inline bool has_class(char ch, unsigned char char_class) {
+    return char_classes[static_cast<unsigned char>(ch)] & char_class;
+}
+
+// Devuelve la primera posición en [pos, end) cuyo carácter no pertenece a la clase.
+static size_t scan_scalar(const char* data, size_t pos, size_t end, unsigned char char_class) {
+    while (pos < end && has_class(data[pos], char_class)) {
+        ++pos;
+    }
+    return pos;
+}
+
+#ifdef LEXER_HAS_X86_SIMD
+// Bytes de v dentro de [lo, hi] (comparación sin signo)
+__attribute__((target("sse2")))
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    __m128i limit = _mm_set1_epi8(static_cast<char>(hi - lo));
+    return _mm_cmpeq_epi8(_mm_max_epu8(shifted, limit), limit);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i class_mask_sse2(__m128i v, unsigned char char_class) {
+    if (char_class == CLASS_SPACE) {
+        return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), in_range_sse2(v, '\t', '\r'));
+    }
+    __m128i digits = in_range_sse2(v, '0', '9');
+    if (char_class == CLASS_DIGIT) {
+        return digits;
+    }
+    __m128i letters = in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(digits, letters), underscore);
+}
+
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char* data, size_t pos, size_t end, unsigned char char_class) {
+    while (pos + 16 <= end) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned outside = ~static_cast<unsigned>(_mm_movemask_epi8(class_mask_sse2(v, char_class))) & 0xFFFFu;
+        if (outside) {
+            return pos + __builtin_ctz(outside);
+        }
+        pos += 16;
+    }
+    return scan_scalar(data, pos, end, char_class);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    __m256i limit = _mm256_set1_epi8(static_cast<char>(hi - lo));
+    return _mm256_cmpeq_epi8(_mm256_max_epu8(shifted, limit), limit);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char* data, size_t pos, size_t end, unsigned char char_class) {
+    while (pos + 32 <= end) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i mask;
+        if (char_class == CLASS_SPACE) {
+            mask = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), in_range_avx2(v, '\t', '\r'));
+        } else {
+            mask = in_range_avx2(v, '0', '9');
+            if (char_class != CLASS_DIGIT) {
+                __m256i letters = in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+                __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+                mask = _mm256_or_si256(mask, _mm256_or_si256(letters, underscore));
+            }
+        }
+        uint32_t outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+        if (outside) {
+            return pos + __builtin_ctz(outside);
+        }
+        pos += 32;
+    }
+    return scan_sse2(data, pos, end, char_class);
+}
+#endif
+
+using ScanFn = size_t (*)(const char*, size_t, size_t, unsigned char);
+
+// Se elige la implementación una sola vez según la CPU en la que corremos
+static ScanFn select_scan() {
+#ifdef LEXER_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return scan_avx2;
+    if (__builtin_cpu_supports("sse2")) return scan_sse2;
+#endif
+    return scan_scalar;
+}
+
+static const ScanFn scan_class = select_scan();
+
+Lexer::Lexer(const std::string& src, uint32_t first_line, uint32_t first_column)
+    : source(src), character(0), read_position(0), position(0), line(first_line),
+      line_start(1 - static_cast<std::ptrdiff_t>(first_column)) {
     read_char();
 }
 
+Lexer::Lexer(std::istream& in)
+    : input(&in), character(0), read_position(0), position(0) {
+    read_char();
+}
+
+// Agrega la siguiente línea de la entrada al buffer. Devuelve false en EOF.
+bool Lexer::fill_buffer() {
+    if (!input) return false;
+    std::string line;
+    if (!std::getline(*input, line)) {
+        input = nullptr;
+        return false;
+    }
+    source += line;
+    source += '\n';
+    return true;
+}
+
+// Elimina del buffer el texto que ya fue convertido en tokens.
+// Solo se llama entre tokens, así que no hay literales a medio leer.
+void Lexer::discard_consumed() {
+    source.erase(0, position);
+    read_position -= position;
+    counted_position -= position;
+    line_start -= static_cast<std::ptrdiff_t>(position);
+    position = 0;
+}
+
+// Avanza la cuenta de líneas hasta position, saltando de un '\n' al siguiente
+void Lexer::count_lines() {
+    const char* data = source.data();
+    size_t end = std::min(position, source.size());   // en EOF position queda pasado el final
+    while (counted_position < end) {
+        const void* newline = std::memchr(data + counted_position, '\n', end - counted_position);
+        if (!newline) break;
+        counted_position = static_cast<const char*>(newline) - data + 1;
+        ++line;
+        line_start = static_cast<std::ptrdiff_t>(counted_position);
+    }
+    counted_position = position;
+}
+
 void Lexer::read_char() {
+    while (read_position >= source.size() && fill_buffer()) {
+    }
     if (read_position >= source.size()) {
         character = 0; // Null char para EOF
     } else {
@@ -16,120 +196,138 @@ void Lexer::read_char() {
     read_position++;
 }
 
-char Lexer::peek_character() const {
+char Lexer::peek_character() {
+    while (read_position >= source.size() && fill_buffer()) {
+    }
     if (read_position >= source.size()) {
         return 0;
     }
     return source[read_position];
 }
 
-void Lexer::skip_whitespace() {
-    while (std::isspace(character)) {
-        read_char();
+// Avanza sobre todos los caracteres de la clase dada, escaneando por bloques.
+// En modo streaming sigue leyendo líneas mientras el bloque llegue al final.
+void Lexer::advance_while(unsigned char char_class) {
+    if (!has_class(character, char_class)) return;
+    size_t end = scan_class(source.data(), position, source.size(), char_class);
+    while (end == source.size() && fill_buffer()) {
+        end = scan_class(source.data(), end, source.size(), char_class);
     }
+    position = end;
+    read_position = end + 1;
+    character = end < source.size() ? source[end] : 0;
+}
+
+void Lexer::skip_whitespace() {
+    advance_while(CLASS_SPACE);
 }
 
 bool Lexer::is_number(char ch) const {
-    return std::isdigit(static_cast<unsigned char>(ch));
+    return has_class(ch, CLASS_DIGIT);
 }
 
 bool Lexer::is_letter(char ch) const {
-    return std::isalpha(static_cast<unsigned char>(ch)) || ch == '_';
+    return has_class(ch, CLASS_IDENT) && !has_class(ch, CLASS_DIGIT);
 }
 
-std::string Lexer::read_number() {
-    size_t initial_position = position;
-    while (is_number(character)) {
-        read_char();
-    }
-    return source.substr(initial_position, position - initial_position);
+void TokenBuffer::push(TokenType type, std::string_view literal, uint32_t line, uint32_t column) {
+    types.push_back(type);
+    offsets.push_back(static_cast<uint32_t>(text.size()));
+    lengths.push_back(static_cast<uint32_t>(literal.size()));
+    lines.push_back(line);
+    columns.push_back(column);
+    text += literal;
 }
 
-std::string Lexer::read_literal() {
-    size_t initial_position = position;
-    while (is_letter(character) || is_number(character)) {
-        read_char();
-    }
-    return source.substr(initial_position, position - initial_position);
+void TokenBuffer::discard_before(size_t index) {
+    if (index == 0 || index > size()) return;
+    size_t consumed_text = index < size() ? offsets[index] : text.size();
+    types.erase(types.begin(), types.begin() + index);
+    offsets.erase(offsets.begin(), offsets.begin() + index);
+    lengths.erase(lengths.begin(), lengths.begin() + index);
+    lines.erase(lines.begin(), lines.begin() + index);
+    columns.erase(columns.begin(), columns.begin() + index);
+    text.erase(0, consumed_text);
+    for (auto& offset : offsets) offset -= static_cast<uint32_t>(consumed_text);
 }
 
-Token Lexer::next_token() {
-    skip_whitespace();
+bool Lexer::tokenize(TokenBuffer& out, size_t max_tokens) {
+    for (size_t i = 0; i < max_tokens; ++i) {
+        skip_whitespace();
+        count_lines();
+        uint32_t token_line = line;
+        uint32_t token_column = static_cast<uint32_t>(static_cast<std::ptrdiff_t>(position) - line_start + 1);
 
-    Token token;
+        if (input && position > COMPACT_THRESHOLD) {
+            discard_consumed();
+        }
 
+        size_t start = position;
+        TokenType type = scan_token();
+        size_t length = type == TokenType::EOF_TOKEN ? 0 : position - start;
+        out.push(type, std::string_view(source).substr(start, length), token_line, token_column);
+        if (type == TokenType::EOF_TOKEN) return true;
+    }
+    return false;
+}
+
+// Reconoce un token a partir de character y deja position justo después
+TokenType Lexer::scan_token() {
     switch (character) {
         case '=':
             if (peek_character() == '=') {
-                char current_char = character;
                 read_char();
-                token = Token(TokenType::EQ, std::string(1, current_char) + character);
-            } else {
-                token = Token(TokenType::ASSIGN, std::string(1, character));
+                read_char();
+                return TokenType::EQ;
             }
-            break;
+            read_char();
+            return TokenType::ASSIGN;
         case '!':
             if (peek_character() == '=') {
-                char current_char = character;
                 read_char();
-                token = Token(TokenType::NOT_EQ, std::string(1, current_char) + character);
-            } else {
-                token = Token(TokenType::BANG, std::string(1, character));
+                read_char();
+                return TokenType::NOT_EQ;
             }
-            break;
-        case '+':
-            token = Token(TokenType::PLUS, std::string(1, character));
-            break;
-        case '-':
-            token = Token(TokenType::MINUS, std::string(1, character));
-            break;
-        case '*':
-            token = Token(TokenType::ASTERISK, std::string(1, character));
-            break;
-        case '/':
-            token = Token(TokenType::SLASH, std::string(1, character));
-            break;
-        case '<':
-            token = Token(TokenType::LT, std::string(1, character));
-            break;
-        case '>':
-            token = Token(TokenType::GT, std::string(1, character));
-            break;
-        case ';':
-            token = Token(TokenType::SEMICOLON, std::string(1, character));
-            break;
-        case ',':
-            token = Token(TokenType::COMMA, std::string(1, character));
-            break;
-        case '(':
-            token = Token(TokenType::LPAREN, std::string(1, character));
-            break;
-        case ')':
-            token = Token(TokenType::RPAREN, std::string(1, character));
-            break;
-        case '{':
-            token = Token(TokenType::LBRACE, std::string(1, character));
-            break;
-        case '}':
-            token = Token(TokenType::RBRACE, std::string(1, character));
-            break;
+            read_char();
+            return TokenType::BANG;
+        case '"':
+            return scan_string();
         case 0:
-            token = Token(TokenType::EOF_TOKEN, "");
-            break;
+            return TokenType::EOF_TOKEN;
         default:
-            if (is_letter(character)) {
-                std::string literal = read_literal();
-                TokenType type = lookup_token_type(literal);
-                return Token(type, literal);  // ⚠️ cuidado, no avanzar después
-            } else if (is_number(character)) {
-                std::string number = read_number();
-                return Token(TokenType::INT, number); // ⚠️ igual acá
-            } else {
-                token = Token(TokenType::ILLEGAL, std::string(1, character));
-            }
             break;
     }
 
+    if (is_letter(character)) {
+        size_t start = position;
+        advance_while(CLASS_IDENT);
+        return lookup_token_type(std::string_view(source).substr(start, position - start));
+    }
+    if (is_number(character)) {
+        advance_while(CLASS_DIGIT);
+        return TokenType::INT;
+    }
+
+    TokenType type = single_char_tokens[static_cast<unsigned char>(character)];
     read_char();
-    return token;
+    return type;
+}
+
+// Cadena de una sola línea. El token lleva las comillas y las secuencias de
+// escape tal como están escritas (las resuelve el parser); si la línea o la
+// entrada terminan antes de cerrarla, el token llega hasta ahí y el parser
+// informa el error.
+TokenType Lexer::scan_string() {
+    while (true) {
+        read_char();
+        if (character == '"') {
+            read_char();
+            return TokenType::STRING;
+        }
+        if (character == 0 || character == '\n') return TokenType::STRING;
+        if (character == '\\') {
+            read_char();
+            if (character == 0 || character == '\n') return TokenType::STRING;
+        }
+    }
 }
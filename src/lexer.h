@@ -1,29 +1,81 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <cstddef>
 #include <string>
+#include <istream>
+#include <string_view>
+#include <vector>
 #include "tokens.h"
 
+// Tokens como estructura de arreglos: el parser decide mirando solo types,
+// y los literales quedan uno detrás del otro en text
+struct TokenBuffer {
+    std::vector<TokenType> types;
+    std::vector<uint32_t> offsets;   // en text
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> lines;
+    std::vector<uint32_t> columns;
+    std::string text;
+
+    size_t size() const { return types.size(); }
+
+    std::string_view literal(size_t index) const {
+        return std::string_view(text).substr(offsets[index], lengths[index]);
+    }
+
+    // Token suelto, para guardarlo en el AST
+    Token token(size_t index) const {
+        return Token(types[index], std::string(literal(index)), lines[index], columns[index]);
+    }
+
+    void push(TokenType type, std::string_view literal, uint32_t line, uint32_t column);
+    // Descarta los tokens anteriores a index (modo streaming)
+    void discard_before(size_t index);
+};
+
 class Lexer {
 public:
-    explicit Lexer(const std::string& source);
+    // first_line/first_column: para un trozo de un fuente más grande, así
+    // los tokens llevan su posición en el original
+    explicit Lexer(const std::string& source, uint32_t first_line = 1, uint32_t first_column = 1);
+    // Modo streaming: lee la entrada por líneas a medida que se necesita
+    // y descarta el texto ya consumido para mantener la memoria acotada.
+    explicit Lexer(std::istream& input);
 
-    Token next_token();
+    // Agrega a out hasta max_tokens tokens; true si ya llegó al EOF
+    bool tokenize(TokenBuffer& out, size_t max_tokens);
+    // Con entrada por líneas conviene pedir de a un token: leer más adelante
+    // bloquearía esperando texto que todavía no se escribió
+    bool streaming() const { return input != nullptr; }
 
 private:
     std::string source;
+    std::istream* input = nullptr;
     char character;
     size_t read_position;
     size_t position;
+    // Líneas contadas hasta counted_position; line_start es donde empieza
+    // la línea actual (negativo si ya se descartó, ver discard_consumed)
+    uint32_t line = 1;
+    std::ptrdiff_t line_start = 0;
+    size_t counted_position = 0;
+
+    // Cuánto texto ya consumido se tolera antes de compactar el buffer
+    static constexpr size_t COMPACT_THRESHOLD = 64 * 1024;
 
     void read_char();
-    char peek_character() const;
+    void advance_while(unsigned char char_class);
+    char peek_character();
+    bool fill_buffer();
+    void discard_consumed();
     void skip_whitespace();
+    void count_lines();
     bool is_number(char ch) const;
     bool is_letter(char ch) const;
     bool is_operator(char ch) const;
-    std::string read_number();
-    std::string read_literal();
+    TokenType scan_token();
+    TokenType scan_string();
 };
 
-#endif // LEXER_H
\ No newline at end of file
+#endif // LEXER_H
@@ -0,0 +1,388 @@
+#include "loop_tier.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class SlotType { INT, BOOL };
+
+enum class LoopOp : unsigned char {
+    CONST,          // push arg
+    LOAD,           // push slots[arg]
+    STORE,          // slots[arg] = pop
+    ADD, SUB, MUL, DIV,
+    EQ, NE, LT, GT,
+    NEG, NOT,
+    JUMP,           // pc = arg
+    JUMP_IF_FALSE,  // if (!pop) pc = arg
+    SET_RESULT,     // resultado = pop, con tipo arg
+    RESULT_NULL,    // resultado = null
+    CLEAR_RESULT,   // resultado = nada (nullptr en el intérprete)
+    HALT,
+};
+
+struct LoopInstr {
+    LoopOp op;
+    int arg;
+};
+
+enum class ResultKind { NONE, INT, BOOL, NULL_VALUE };
+
+struct Slot {
+    std::string name;
+    SlotType type;
+    bool written = false;    // por un let: se liga en el entorno del loop
+    bool assigned = false;   // por x = ...: se actualiza donde esté ligada
+};
+
+class LoopCompiler {
+public:
+    explicit LoopCompiler(Environment& env) : env(env) {}
+
+    bool compile(WhileStatement* loop) {
+        return compile_while(loop) && emit(LoopOp::HALT) && consistent_writes();
+    }
+
+    bool compile(ForStatement* loop) {
+        return compile_for(loop) && emit(LoopOp::HALT) && consistent_writes();
+    }
+
+    std::vector<LoopInstr> code;
+    size_t outer_exit_pc = 0;   // salto condicional del loop exterior
+    std::vector<Slot> slots;
+    std::vector<int> initial_values;
+    int max_stack = 0;
+
+private:
+    Environment& env;
+    int depth = 0;
+
+    bool emit(LoopOp op, int arg = 0) {
+        code.push_back({op, arg});
+        return true;
+    }
+
+    void push() {
+        if (++depth > max_stack) max_stack = depth;
+    }
+
+    // Busca o crea el slot de una variable; su tipo sale del valor actual en env
+    int slot_for(const std::string& name) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].name == name) return static_cast<int>(i);
+        }
+        auto value = env.get(name);
+        if (!value) return -1;
+        if (value->type() == ObjectType::INTEGER_OBJ) {
+            slots.push_back({name, SlotType::INT});
+            initial_values.push_back(std::static_pointer_cast<Integer>(value)->value);
+        } else if (value->type() == ObjectType::BOOLEAN_OBJ) {
+            slots.push_back({name, SlotType::BOOL});
+            initial_values.push_back(std::static_pointer_cast<Boolean>(value)->value);
+        } else {
+            return -1;
+        }
+        return static_cast<int>(slots.size() - 1);
+    }
+
+    bool compile_expression(Expression* node, SlotType& type) {
+        if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+            emit(LoopOp::CONST, int_lit->value);
+            push();
+            type = SlotType::INT;
+            return true;
+        }
+
+        if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
+            emit(LoopOp::CONST, bool_lit->value);
+            push();
+            type = SlotType::BOOL;
+            return true;
+        }
+
+        if (auto ident = dynamic_cast<Identifier*>(node)) {
+            int slot = slot_for(ident->value);
+            if (slot < 0) return false;
+            emit(LoopOp::LOAD, slot);
+            push();
+            type = slots[slot].type;
+            return true;
+        }
+
+        if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+            SlotType right;
+            if (!compile_expression(prefix->right.get(), right)) return false;
+            if (prefix->op == "-" && right == SlotType::INT) {
+                type = SlotType::INT;
+                return emit(LoopOp::NEG);
+            }
+            if (prefix->op == "!" && right == SlotType::BOOL) {
+                type = SlotType::BOOL;
+                return emit(LoopOp::NOT);
+            }
+            return false;
+        }
+
+        if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+            SlotType left, right;
+            if (!compile_expression(infix->left.get(), left)) return false;
+            if (!compile_expression(infix->right.get(), right)) return false;
+            if (left != right) return false;
+            depth--;
+
+            const std::string& op = infix->op;
+            if (op == "==" || op == "!=") {
+                type = SlotType::BOOL;
+                return emit(op == "==" ? LoopOp::EQ : LoopOp::NE);
+            }
+            if (left != SlotType::INT) return false;
+            if (op == "<" || op == ">") {
+                type = SlotType::BOOL;
+                return emit(op == "<" ? LoopOp::LT : LoopOp::GT);
+            }
+            type = SlotType::INT;
+            if (op == "+") return emit(LoopOp::ADD);
+            if (op == "-") return emit(LoopOp::SUB);
+            if (op == "*") return emit(LoopOp::MUL);
+            if (op == "/") return emit(LoopOp::DIV);
+            return false;
+        }
+
+        return false;
+    }
+
+    bool compile_block(BlockStatement* block) {
+        if (block->statements.empty()) {
+            return emit(LoopOp::CLEAR_RESULT);
+        }
+        for (auto& stmt : block->statements) {
+            if (!compile_statement(stmt.get())) return false;
+        }
+        return true;
+    }
+
+    // Una variable ligada con let y también asignada podría terminar en
+    // entornos distintos según el orden: ese caso queda en el intérprete
+    bool consistent_writes() const {
+        for (const auto& slot : slots) {
+            if (slot.written && slot.assigned) return false;
+        }
+        return true;
+    }
+
+    // let x = valor o x = valor: deja el valor en el slot (y en la pila si keep)
+    bool compile_store(const std::string& name, Expression* value, bool is_let, bool keep) {
+        SlotType type;
+        if (!compile_expression(value, type)) return false;
+        int slot = slot_for(name);
+        if (slot < 0 || slots[slot].type != type) return false;
+        // Una global de un entorno sellado: el intérprete informa el error
+        if (!is_let && env.assignable(name) != AssignResult::ASSIGNED) return false;
+        (is_let ? slots[slot].written : slots[slot].assigned) = true;
+        depth--;
+        emit(LoopOp::STORE, slot);
+        if (!keep) return true;
+        emit(LoopOp::LOAD, slot);
+        return emit(LoopOp::SET_RESULT, static_cast<int>(type));
+    }
+
+    bool compile_statement(Statement* node) {
+        if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
+            return compile_store(let_stmt->name, let_stmt->value.get(), true, true);
+        }
+
+        if (auto while_stmt = dynamic_cast<WhileStatement*>(node)) {
+            emit(LoopOp::CLEAR_RESULT);
+            return compile_while(while_stmt);
+        }
+
+        if (auto for_stmt = dynamic_cast<ForStatement*>(node)) {
+            if (for_stmt->init && !compile_silent_let(for_stmt->init.get())) return false;
+            emit(LoopOp::CLEAR_RESULT);
+            return compile_for(for_stmt);
+        }
+
+        if (auto stmt = dynamic_cast<ExpressionStatement*>(node)) {
+            if (auto if_expr = dynamic_cast<IfExpression*>(stmt->expression.get())) {
+                return compile_if(if_expr);
+            }
+            if (auto assign = dynamic_cast<AssignExpression*>(stmt->expression.get())) {
+                return compile_store(assign->name, assign->value.get(), false, true);
+            }
+            SlotType type;
+            if (!stmt->expression || !compile_expression(stmt->expression.get(), type)) return false;
+            depth--;
+            return emit(LoopOp::SET_RESULT, static_cast<int>(type));
+        }
+
+        return false;
+    }
+
+    // Solo ifs como sentencia: su valor queda directamente en el resultado
+    bool compile_if(IfExpression* if_expr) {
+        SlotType cond;
+        if (!compile_expression(if_expr->condition.get(), cond) || cond != SlotType::BOOL) return false;
+        depth--;
+        size_t jump_to_else = code.size();
+        emit(LoopOp::JUMP_IF_FALSE);
+        if (!compile_block(if_expr->consequence.get())) return false;
+        size_t jump_to_end = code.size();
+        emit(LoopOp::JUMP);
+        code[jump_to_else].arg = static_cast<int>(code.size());
+        if (if_expr->alternative) {
+            if (!compile_block(if_expr->alternative.get())) return false;
+        } else {
+            emit(LoopOp::RESULT_NULL);
+        }
+        code[jump_to_end].arg = static_cast<int>(code.size());
+        return true;
+    }
+
+    // init y actualización de un for: asignan sin tocar el resultado
+    bool compile_silent_let(Statement* node) {
+        if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
+            return compile_store(let_stmt->name, let_stmt->value.get(), true, false);
+        }
+        auto stmt = dynamic_cast<ExpressionStatement*>(node);
+        auto assign = stmt ? dynamic_cast<AssignExpression*>(stmt->expression.get()) : nullptr;
+        return assign && compile_store(assign->name, assign->value.get(), false, false);
+    }
+
+    bool compile_for(ForStatement* loop) {
+        // Sin condición solo se sale con break, que este nivel no soporta
+        if (!loop->condition) return false;
+        int loop_start = static_cast<int>(code.size());
+        SlotType cond;
+        if (!compile_expression(loop->condition.get(), cond) || cond != SlotType::BOOL) return false;
+        depth--;
+        size_t exit_jump = code.size();
+        emit(LoopOp::JUMP_IF_FALSE);
+        if (loop_start == 0) outer_exit_pc = exit_jump;
+        if (!compile_block(loop->body.get())) return false;
+        if (loop->update && !compile_silent_let(loop->update.get())) return false;
+        emit(LoopOp::JUMP, loop_start);
+        code[exit_jump].arg = static_cast<int>(code.size());
+        return true;
+    }
+
+    bool compile_while(WhileStatement* loop) {
+        int loop_start = static_cast<int>(code.size());
+        SlotType cond;
+        if (!compile_expression(loop->condition.get(), cond) || cond != SlotType::BOOL) return false;
+        depth--;
+        size_t exit_jump = code.size();
+        emit(LoopOp::JUMP_IF_FALSE);
+        if (loop_start == 0) outer_exit_pc = exit_jump;
+        if (!compile_block(loop->body.get())) return false;
+        emit(LoopOp::JUMP, loop_start);
+        code[exit_jump].arg = static_cast<int>(code.size());
+        return true;
+    }
+};
+
+// Resultado de la última sentencia ejecutada y si el loop exterior dio al
+// menos una vuelta
+struct LoopRun {
+    ResultKind kind = ResultKind::NONE;
+    int value = 0;
+    bool iterated = false;
+    // Por slot, si algún STORE llegó a ejecutarse: un let en una rama que
+    // no corrió no debe ligar nada al volver al entorno
+    std::vector<unsigned char> stored;
+};
+
+LoopRun execute(const LoopCompiler& compiled, std::vector<int>& slots) {
+    const std::vector<LoopInstr>& code = compiled.code;
+    std::vector<int> stack(static_cast<size_t>(compiled.max_stack) + 1);
+    int* sp = stack.data();
+    LoopRun run;
+    run.stored.assign(slots.size(), 0);
+
+    size_t pc = 0;
+    while (true) {
+        const LoopInstr& in = code[pc++];
+        switch (in.op) {
+            case LoopOp::CONST: *sp++ = in.arg; break;
+            case LoopOp::LOAD: *sp++ = slots[in.arg]; break;
+            case LoopOp::STORE:
+                slots[in.arg] = *--sp;
+                run.stored[in.arg] = 1;
+                break;
+            case LoopOp::ADD: sp--; sp[-1] = sp[-1] + sp[0]; break;
+            case LoopOp::SUB: sp--; sp[-1] = sp[-1] - sp[0]; break;
+            case LoopOp::MUL: sp--; sp[-1] = sp[-1] * sp[0]; break;
+            case LoopOp::DIV: sp--; sp[-1] = sp[-1] / sp[0]; break;
+            case LoopOp::EQ: sp--; sp[-1] = sp[-1] == sp[0]; break;
+            case LoopOp::NE: sp--; sp[-1] = sp[-1] != sp[0]; break;
+            case LoopOp::LT: sp--; sp[-1] = sp[-1] < sp[0]; break;
+            case LoopOp::GT: sp--; sp[-1] = sp[-1] > sp[0]; break;
+            case LoopOp::NEG: sp[-1] = -sp[-1]; break;
+            case LoopOp::NOT: sp[-1] = !sp[-1]; break;
+            case LoopOp::JUMP: pc = static_cast<size_t>(in.arg); break;
+            case LoopOp::JUMP_IF_FALSE:
+                if (!*--sp) {
+                    pc = static_cast<size_t>(in.arg);
+                } else if (pc - 1 == compiled.outer_exit_pc) {
+                    run.iterated = true;
+                }
+                break;
+            case LoopOp::SET_RESULT:
+                run.value = *--sp;
+                run.kind = static_cast<SlotType>(in.arg) == SlotType::INT ? ResultKind::INT : ResultKind::BOOL;
+                break;
+            case LoopOp::RESULT_NULL: run.kind = ResultKind::NULL_VALUE; break;
+            case LoopOp::CLEAR_RESULT: run.kind = ResultKind::NONE; break;
+            case LoopOp::HALT: return run;
+        }
+    }
+}
+
+template <typename Loop>
+bool tier_up(Loop* loop, const std::shared_ptr<Environment>& env, std::shared_ptr<Object>& result) {
+    LoopCompiler compiler(*env);
+    if (!compiler.compile(loop)) {
+        return false;
+    }
+
+    std::vector<int> slots = compiler.initial_values;
+    LoopRun run = execute(compiler, slots);
+
+    // Transferir el estado del loop de vuelta al entorno
+    for (size_t i = 0; i < compiler.slots.size(); ++i) {
+        const Slot& slot = compiler.slots[i];
+        if (!run.stored[i]) continue;
+        std::shared_ptr<Object> value;
+        if (slot.type == SlotType::INT) {
+            value = std::make_shared<Integer>(slots[i]);
+        } else {
+            value = std::make_shared<Boolean>(slots[i] != 0);
+        }
+        if (slot.written) {
+            env->set(slot.name, std::move(value));
+        } else {
+            env->assign(slot.name, std::move(value));
+        }
+    }
+
+    if (run.iterated) {
+        switch (run.kind) {
+            case ResultKind::INT: result = std::make_shared<Integer>(run.value); break;
+            case ResultKind::BOOL: result = std::make_shared<Boolean>(run.value != 0); break;
+            case ResultKind::NULL_VALUE: result = std::make_shared<Null>(); break;
+            case ResultKind::NONE: result = nullptr; break;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_loop_tier(WhileStatement* loop, const std::shared_ptr<Environment>& env,
+                   std::shared_ptr<Object>& result) {
+    return tier_up(loop, env, result);
+}
+
+bool run_loop_tier(ForStatement* loop, const std::shared_ptr<Environment>& env,
+                   std::shared_ptr<Object>& result) {
+    return tier_up(loop, env, result);
+}
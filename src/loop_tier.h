@@ -0,0 +1,29 @@
+#ifndef LOOP_TIER_H
+#define LOOP_TIER_H
+
+#include <memory>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+
+// Vueltas que da un while en el intérprete antes de intentar subirlo de nivel
+constexpr int LOOP_TIER_THRESHOLD = 1000;
+
+// On-stack replacement de un while que ya está corriendo: compila la
+// condición y el cuerpo a un bytecode sobre slots enteros sin boxing, carga
+// en los slots los valores actuales de env, ejecuta las vueltas que faltan y
+// al salir escribe en env las variables asignadas. Si hubo al menos una
+// vuelta, deja en result el valor del cuerpo en la última.
+//
+// Devuelve false si el loop usa algo que este nivel no soporta (llamadas,
+// funciones, variables que no son enteros o booleanos...). En ese caso no
+// se modificó nada y el intérprete continúa con el loop.
+bool run_loop_tier(WhileStatement* loop, const std::shared_ptr<Environment>& env,
+                   std::shared_ptr<Object>& result);
+
+// Lo mismo para un for, llamado después de la actualización de una vuelta
+// (el init ya corrió y no se vuelve a ejecutar).
+bool run_loop_tier(ForStatement* loop, const std::shared_ptr<Environment>& env,
+                   std::shared_ptr<Object>& result);
+
+#endif // LOOP_TIER_H
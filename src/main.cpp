@@ -2,43 +2,335 @@
 #include <string>
 #include <memory>
 #include <sstream>
+#include <functional>
+#include <iterator>
+#include <charconv>
+#include <vector>
 #include "lexer.h"
 #include "parser.h"
 #include "evaluator.h"
+#include "stackless_evaluator.h"
+#include "event_loop.h"
 #include "environment.h"
+#include "prelude.h"
+#include "server.h"
+#include "snapshot.h"
+#include "pool_allocator.h"
+#include "type_inference.h"
+#include "alloc_profiler.h"
+#include "parallel_parser.h"
+#include "inlining.h"
+#include "batch.h"
+
+// Evaluador elegido por línea de comandos (recursivo o sin pila). flow queda
+// en RETURN si el nodo terminó con un return de nivel superior.
+using EvalFn = std::function<std::shared_ptr<Object>(Node*, std::shared_ptr<Environment>, Flow&)>;
+
+// Modo streaming (--stream): cada sentencia de nivel superior se evalúa apenas
+// el parser la termina, y se libera después de ejecutarla. Pensado para
+// scripts largos enviados por stdin.
+static int run_stream(std::istream& input, std::shared_ptr<Environment> env, const EvalFn& evaluate) {
+    Lexer lexer(input);
+    Parser parser(lexer);
+    size_t reported_errors = 0;
+
+    while (!parser.at_eof()) {
+        auto stmt = parser.next_statement();
+
+        if (parser.errors.size() > reported_errors) {
+            std::cerr << "Errores de parsing:\n";
+            for (size_t i = reported_errors; i < parser.errors.size(); ++i) {
+                std::cerr << "  - " << parser.errors[i] << "\n";
+            }
+            return 1;
+        }
+        if (!stmt) continue;
+
+        auto type_errors = infer_types(stmt.get(), env);
+        if (!type_errors.empty()) {
+            std::cerr << "Errores de tipos:\n";
+            for (const auto& err : type_errors) {
+                std::cerr << "  - " << err << "\n";
+            }
+            return 1;
+        }
+        inline_calls(stmt.get(), env);
+
+        Flow flow = Flow::NORMAL;
+        auto result = evaluate(stmt.get(), env, flow);
+        if (flow == Flow::RETURN) {
+            // return de nivel superior: termina el script
+            std::cout << "Resultado: " << (result ? result->inspect() : "null") << "\n";
+            return 0;
+        }
+        if (result && dynamic_cast<ExpressionStatement*>(stmt.get())) {
+            std::cout << "Resultado: " << result->inspect() << "\n";
+        }
+    }
+    return 0;
+}
+
+// --pool-stats: contadores del asignador de entornos y funciones (hilo principal)
+static void report_pool_stats() {
+    const PoolStats& stats = pool_stats();
+    std::cerr << "# pool allocations=" << stats.allocations << " reused=" << stats.reused
+              << " releases=" << stats.releases << " slabs=" << stats.slabs
+              << " oversized=" << stats.oversized << "\n";
+}
+
+// Modo asíncrono con archivos (--async a.txt b.txt ...): todos los scripts
+// corren a la vez en un mismo EventLoop, cada uno con su propia copia del
+// entorno inicial (el preludio, si hay uno).
+static int run_async_files(const std::vector<std::string>& files, const std::shared_ptr<Environment>& env, EventLoop& loop) {
+    int status = 0;
+    for (const auto& file : files) {
+        std::string source;
+        if (!read_source_file(file, source)) {
+            status = 1;
+            continue;
+        }
+
+        std::vector<std::string> parse_errors;
+        std::shared_ptr<Program> program = parse_source(source, parse_errors);
+        if (!parse_errors.empty()) {
+            std::cerr << "Errores de parsing en " << file << ":\n";
+            for (const auto& err : parse_errors) {
+                std::cerr << "  - " << err << "\n";
+            }
+            status = 1;
+            continue;
+        }
+        auto type_errors = infer_types(program.get(), env);
+        if (!type_errors.empty()) {
+            std::cerr << "Errores de tipos en " << file << ":\n";
+            for (const auto& err : type_errors) {
+                std::cerr << "  - " << err << "\n";
+            }
+            status = 1;
+            continue;
+        }
+        inline_calls(program.get(), env);
+
+        loop.spawn(program, env->fork(), [file](std::shared_ptr<Object> result) {
+            std::cout << file << ": " << (result ? "Resultado: " + result->inspect() : "Resultado nulo o error de ejecución.") << "\n";
+        });
+    }
+    loop.run();
+    return status;
+}
+
+// Modo lote (--batch=filas.csv): el programa de stdin se evalúa sobre cada
+// fila del CSV, con las columnas como variables y el entorno inicial (el
+// preludio, si hay uno) como globales; escribe un resultado por línea (vacía
+// si la fila falló)
+static int run_batch(const std::string& csv_path, const std::shared_ptr<Environment>& env) {
+    BatchProgram::Inputs inputs;
+    std::vector<Column> columns;
+    if (!read_columns_csv(csv_path, inputs, columns)) return 1;
+
+    std::string source((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    std::vector<std::string> parse_errors;
+    std::shared_ptr<Program> program = parse_source(source, parse_errors);
+    if (!parse_errors.empty()) {
+        std::cerr << "Errores de parsing:\n";
+        for (const auto& err : parse_errors) {
+            std::cerr << "  - " << err << "\n";
+        }
+        return 1;
+    }
+
+    auto batch = BatchProgram::compile(program, std::move(inputs), env);
+    if (!batch) return 1;
+    BatchResult result = batch->run(columns);
+    std::string out;
+    for (size_t row = 0; row < result.size(); ++row) {
+        out += result.inspect(row);
+        out += '\n';
+        if (out.size() >= 1 << 16) {
+            std::cout << out;
+            out.clear();
+        }
+    }
+    std::cout << out;
+    return 0;
+}
+
+// Valor numérico de una opción (--max-depth=N). false, con el error ya
+// informado, si text no es un número entero no negativo
+static bool parse_count_option(const std::string& option, const std::string& text, size_t& out) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    auto [end, error] = std::from_chars(first, last, out);
+    if (text.empty() || error != std::errc() || end != last) {
+        std::cerr << "Valor inválido para " << option << ": '" << text << "' (se espera un entero no negativo)\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    auto env = std::make_shared<Environment>();  // ✅ entorno persistente entre ejecuciones
+
+    bool stream = false;
+    bool stackless = false;
+    bool async = false;
+    bool pool_report = false;
+    bool alloc_report = false;
+    size_t max_frames = StacklessEvaluator::DEFAULT_MAX_FRAMES;
+    std::vector<std::string> files;
+    std::string prelude_path;
+    std::string snapshot_path;
+    std::string save_snapshot_path;
+    std::string batch_path;
+    ServerOptions server_options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            stream = true;
+        } else if (arg == "--stackless") {
+            stackless = true;
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            // Límite de marcos del evaluador sin pila
+            stackless = true;
+            if (!parse_count_option("--max-depth", arg.substr(std::string("--max-depth=").size()), max_frames)) {
+                return 1;
+            }
+        } else if (arg.rfind("--prelude=", 0) == 0) {
+            prelude_path = arg.substr(std::string("--prelude=").size());
+        } else if (arg.rfind("--snapshot=", 0) == 0) {
+            // Arranca desde un snapshot guardado en vez de evaluar el preludio
+            snapshot_path = arg.substr(std::string("--snapshot=").size());
+        } else if (arg.rfind("--save-snapshot=", 0) == 0) {
+            save_snapshot_path = arg.substr(std::string("--save-snapshot=").size());
+        } else if (arg.rfind("--serve=", 0) == 0) {
+            server_options.socket_path = arg.substr(std::string("--serve=").size());
+        } else if (arg.rfind("--workers=", 0) == 0) {
+            if (!parse_count_option("--workers", arg.substr(std::string("--workers=").size()), server_options.workers)) {
+                return 1;
+            }
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batch_path = arg.substr(std::string("--batch=").size());
+        } else if (arg == "--pool-stats") {
+            pool_report = true;
+        } else if (arg == "--alloc-profile") {
+            // Asignaciones por tipo y por sitio del script; se informan al salir
+            enable_alloc_profiling();
+            alloc_report = true;
+        } else if (arg == "--async") {
+            // Builtins del host sin bloquear: los scripts corren como corrutinas en un EventLoop
+            async = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (!snapshot_path.empty()) {
+        env = load_snapshot(snapshot_path);
+        if (!env) return 1;
+    }
+    if (!prelude_path.empty() && !load_prelude(prelude_path, env)) {
+        return 1;
+    }
+
+    // --save-snapshot: guarda el entorno ya inicializado y termina
+    if (!save_snapshot_path.empty()) {
+        return save_snapshot(env, save_snapshot_path) ? 0 : 1;
+    }
+
+    // Modo servidor: el preludio se evalúa una vez y queda compartido
+    if (!server_options.socket_path.empty()) {
+        ScriptServer server(server_options, env);
+        return server.run();
+    }
+
+    if (!batch_path.empty()) {
+        int status = run_batch(batch_path, env);
+        if (alloc_report) report_alloc_profile(std::cerr);
+        return status;
+    }
+
+    // El preludio queda sellado, como en el servidor: los scripts escriben en
+    // su propia capa y spawn lo comparte con las tareas en vez de copiarlo
+    if (!prelude_path.empty() || !snapshot_path.empty()) env = env->fork();
+
+    EvalFn evaluate = [](Node* node, std::shared_ptr<Environment> env, Flow& flow) { return eval(node, env, flow); };
+    if (stackless) {
+        auto evaluator = std::make_shared<StacklessEvaluator>(max_frames);
+        evaluate = [evaluator](Node* node, std::shared_ptr<Environment> env, Flow& flow) {
+            auto result = evaluator->eval(node, env);
+            flow = evaluator->flow();
+            return result;
+        };
+    }
+    if (async) {
+        auto loop = std::make_shared<EventLoop>();
+        if (!files.empty()) {
+            int status = run_async_files(files, env, *loop);
+            if (alloc_report) report_alloc_profile(std::cerr);
+            return status;
+        }
+        evaluate = [loop](Node* node, std::shared_ptr<Environment> env, Flow&) {
+            std::shared_ptr<Object> result;
+            // El nodo vive mientras dura esta llamada: alcanza con un shared_ptr sin dueño
+            loop->spawn(std::shared_ptr<Node>(std::shared_ptr<Node>(), node), env,
+                        [&result](std::shared_ptr<Object> value) { result = std::move(value); });
+            loop->run();
+            return result;
+        };
+    }
+
+    if (stream) {
+        int status = run_stream(std::cin, env, evaluate);
+        if (pool_report) report_pool_stats();
+        if (alloc_report) report_alloc_profile(std::cerr);
+        return status;
+    }
 
-int main() {
     std::cout << "Escribe tu programa (usa varias líneas si quieres). Escribe 'run' para ejecutarlo o 'exit' para salir.\n";
 
     std::string line;
     std::stringstream source_buffer;
 
-    auto env = std::make_shared<Environment>();  // ✅ entorno persistente entre ejecuciones
-
     while (true) {
         std::cout << ">> ";
         std::getline(std::cin, line);
 
         if (line == "exit") break;
 
+        // Con --alloc-profile: el perfil hasta ahora, sin salir
+        if (line == "profile" && alloc_report) {
+            report_alloc_profile(std::cerr);
+            continue;
+        }
+
         if (line == "run") {
             std::string source = source_buffer.str();
             source_buffer.str("");
             source_buffer.clear();
 
-            Lexer lexer(source);
-            Parser parser(lexer);
-            auto program = parser.parse_program();
+            std::vector<std::string> parse_errors;
+            auto program = parse_source(source, parse_errors);
 
-            if (!parser.errors.empty()) {
+            if (!parse_errors.empty()) {
                 std::cerr << "Errores de parsing:\n";
-                for (const auto& err : parser.errors) {
+                for (const auto& err : parse_errors) {
+                    std::cerr << "  - " << err << "\n";
+                }
+                continue;
+            }
+            auto type_errors = infer_types(program.get(), env);
+            if (!type_errors.empty()) {
+                std::cerr << "Errores de tipos:\n";
+                for (const auto& err : type_errors) {
                     std::cerr << "  - " << err << "\n";
                 }
                 continue;
             }
+            inline_calls(program.get(), env);
 
-            auto result = eval(program.get(), env);
+            Flow flow = Flow::NORMAL;
+            auto result = evaluate(program.get(), env, flow);
             if (result) {
                 std::cout << "Resultado: " << result->inspect() << "\n";
             } else {
@@ -51,5 +343,7 @@ int main() {
         source_buffer << line << "\n";
     }
 
+    if (pool_report) report_pool_stats();
+    if (alloc_report) report_alloc_profile(std::cerr);
     return 0;
 }
\ No newline at end of file
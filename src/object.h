@@ -6,23 +6,33 @@
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include "alloc_profiler.h"
 
 // Tipo de objeto que representa un valor evaluado
 enum class ObjectType {
     INTEGER_OBJ,
     BOOLEAN_OBJ,
-    RETURN_VALUE_OBJ,
     FUNCTION_OBJ,
-    NULL_OBJ
+    BUILTIN_OBJ,
+    NULL_OBJ,
+    TASK_OBJ,
+    STRING_OBJ     // ver string_object.h
 };
 
 // Forward declaration
 class Environment;
+class HostContext;
+class Object;
+
+// Funciones del host: reciben los argumentos y avisan el resultado por
+// done, que puede llamarse más tarde (operaciones asíncronas)
+using HostCompletion = std::function<void(std::shared_ptr<Object>)>;
+using HostFn = std::function<void(HostContext&, std::vector<std::shared_ptr<Object>>&, HostCompletion)>;
 
 // Clase base
 class Object {
 public:
-    virtual ~Object() = default;
+    virtual ~Object() { profile_release(this); }
     virtual ObjectType type() const = 0;
     virtual std::string inspect() const = 0;
 };
@@ -31,7 +41,7 @@ public:
 class Integer : public Object {
 public:
     int value;
-    Integer(int v) : value(v) {}
+    Integer(int v) : value(v) { profile_allocation(this, typeid(Integer), sizeof(Integer)); }
     ObjectType type() const override { return ObjectType::INTEGER_OBJ; }
     std::string inspect() const override { return std::to_string(value); }
 };
@@ -40,7 +50,7 @@ public:
 class Boolean : public Object {
 public:
     bool value;
-    Boolean(bool v) : value(v) {}
+    Boolean(bool v) : value(v) { profile_allocation(this, typeid(Boolean), sizeof(Boolean)); }
     ObjectType type() const override { return ObjectType::BOOLEAN_OBJ; }
     std::string inspect() const override { return value ? "true" : "false"; }
 };
@@ -48,19 +58,11 @@ public:
 // Null
 class Null : public Object {
 public:
+    Null() { profile_allocation(this, typeid(Null), sizeof(Null)); }
     ObjectType type() const override { return ObjectType::NULL_OBJ; }
     std::string inspect() const override { return "null"; }
 };
 
-// Return value (para return dentro de funciones)
-class ReturnValue : public Object {
-public:
-    std::shared_ptr<Object> value;
-    ReturnValue(std::shared_ptr<Object> v) : value(v) {}
-    ObjectType type() const override { return ObjectType::RETURN_VALUE_OBJ; }
-    std::string inspect() const override { return value->inspect(); }
-};
-
 // Funciones definidas por el usuario
 class Function : public Object {
 public:
@@ -71,7 +73,9 @@ public:
     Function(std::vector<std::string> params,
              std::shared_ptr<BlockStatement> bod,
              std::shared_ptr<Environment> environment)
-        : parameters(std::move(params)), body(std::move(bod)), env(std::move(environment)) {}
+        : parameters(std::move(params)), body(std::move(bod)), env(std::move(environment)) {
+        profile_allocation(this, typeid(Function), sizeof(Function));
+    }
 
     ObjectType type() const override { return ObjectType::FUNCTION_OBJ; }
 
@@ -86,4 +90,20 @@ public:
     }
 };
 
+// Funciones provistas por el host (ver builtins.h)
+class Builtin : public Object {
+public:
+    std::string name;
+    size_t arity;
+    HostFn fn;
+
+    Builtin(std::string nm, size_t ar, HostFn f)
+        : name(std::move(nm)), arity(ar), fn(std::move(f)) {
+        profile_allocation(this, typeid(Builtin), sizeof(Builtin));
+    }
+
+    ObjectType type() const override { return ObjectType::BUILTIN_OBJ; }
+    std::string inspect() const override { return "builtin " + name; }
+};
+
 #endif // OBJECT_H
@@ -0,0 +1,126 @@
+#include "parallel_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string_view>
+#include <thread>
+#include "lexer.h"
+#include "parser.h"
+#include "scheduler.h"
+
+namespace {
+
+// Por debajo de esto no vale la pena repartir
+constexpr size_t PARALLEL_THRESHOLD = 256 * 1024;
+constexpr size_t MIN_CHUNK = 64 * 1024;
+
+struct SourceChunk {
+    size_t begin;
+    size_t end;
+    uint32_t line;
+    uint32_t column;
+};
+
+struct ChunkResult {
+    std::unique_ptr<Program> program;
+    std::vector<std::string> errors;
+};
+
+// Pre-escaneo por bytes: el lenguaje no tiene comentarios y las cadenas se
+// saltean (igual que en Lexer::scan_string, terminan en la comilla sin escapar
+// o en el fin de línea), así que las llaves y paréntesis que quedan son
+// exactamente los de los tokens.
+// Corta en el primer ';' de profundidad 0 después de cada target bytes.
+std::vector<SourceChunk> split_top_level(const std::string& source, size_t target) {
+    std::vector<SourceChunk> chunks;
+    SourceChunk current{0, 0, 1, 1};
+    int depth = 0;
+    uint32_t line = 1;
+    size_t line_start = 0;
+    for (size_t i = 0; i < source.size(); ++i) {
+        switch (source[i]) {
+            case '{':
+            case '(':
+                ++depth;
+                break;
+            case '}':
+            case ')':
+                --depth;
+                break;
+            case '\n':
+                ++line;
+                line_start = i + 1;
+                break;
+            case '"':
+                while (i + 1 < source.size() && source[i + 1] != '"' && source[i + 1] != '\n') {
+                    if (source[i + 1] == '\\' && i + 2 < source.size() && source[i + 2] != '\n') ++i;
+                    ++i;
+                }
+                if (i + 1 < source.size() && source[i + 1] == '"') ++i;
+                break;
+            case ';':
+                if (depth == 0 && i + 1 - current.begin >= target) {
+                    current.end = i + 1;
+                    chunks.push_back(current);
+                    current = SourceChunk{i + 1, 0, line, static_cast<uint32_t>(i + 1 - line_start + 1)};
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    current.end = source.size();
+    chunks.push_back(current);
+    return chunks;
+}
+
+void parse_chunk(const std::string& text, uint32_t line, uint32_t column, bool lazy, ChunkResult& out) {
+    Lexer lexer(text, line, column);
+    Parser parser(lexer);
+    parser.lazy_function_bodies = lazy;
+    out.program = parser.parse_program();
+    out.errors = std::move(parser.errors);
+}
+
+} // namespace
+
+std::unique_ptr<Program> parse_source(const std::string& source, std::vector<std::string>& errors,
+                                      bool lazy_function_bodies) {
+    if (source.size() < PARALLEL_THRESHOLD) {
+        ChunkResult result;
+        parse_chunk(source, 1, 1, lazy_function_bodies, result);
+        errors.insert(errors.end(), result.errors.begin(), result.errors.end());
+        return std::move(result.program);
+    }
+
+    // Varios trozos por hilo para repartir bien aunque los tamaños varíen
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t target = std::max(MIN_CHUNK, source.size() / (threads * 4));
+    std::vector<SourceChunk> chunks = split_top_level(source, target);
+    std::vector<ChunkResult> results(chunks.size());
+
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    std::atomic<size_t> remaining{chunks.size()};
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        scheduler.submit([&, i]() {
+            const SourceChunk& chunk = chunks[i];
+            std::string text = source.substr(chunk.begin, chunk.end - chunk.begin);
+            parse_chunk(text, chunk.line, chunk.column, lazy_function_bodies, results[i]);
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    // Este hilo también parsea mientras espera
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!scheduler.run_one()) std::this_thread::yield();
+    }
+
+    auto program = std::move(results[0].program);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (i > 0) {
+            auto& statements = results[i].program->statements;
+            std::move(statements.begin(), statements.end(), std::back_inserter(program->statements));
+        }
+        errors.insert(errors.end(), results[i].errors.begin(), results[i].errors.end());
+    }
+    return program;
+}
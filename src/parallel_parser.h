@@ -0,0 +1,19 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+// Parsea un fuente completo. Si es grande se parte en trozos en los ';' de
+// nivel superior (fuera de toda llave y paréntesis), que se parsean a la vez
+// en el TaskScheduler; las sentencias y los errores se juntan en el orden
+// del fuente. Los tokens conservan su línea y columna en el original.
+//
+// Con errores de sintaxis la recuperación puede diferir un poco del parseo
+// secuencial, porque cada trozo arranca de cero.
+std::unique_ptr<Program> parse_source(const std::string& source, std::vector<std::string>& errors,
+                                      bool lazy_function_bodies = false);
+
+#endif // PARALLEL_PARSER_H
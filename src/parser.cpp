@@ -1,145 +1,328 @@
 #include "parser.h"
+#include "closure_conversion.h"
+#include "escape_analysis.h"
+#include "induction.h"
+#include "string_object.h"
+#include "type_inference.h"
+#include "value_numbering.h"
+#include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 #include <iostream>
 
-Parser::Parser(Lexer& l) : lexer(l) {
-    next_token();
-    next_token();
+constexpr std::array<Parser::PrefixParseFn, TOKEN_TYPE_COUNT> Parser::prefix_parse_fns = [] {
+    std::array<PrefixParseFn, TOKEN_TYPE_COUNT> table{};
+    table[token_index(TokenType::IDENT)] = &Parser::parse_identifier;
+    table[token_index(TokenType::INT)] = &Parser::parse_integer_literal;
+    table[token_index(TokenType::STRING)] = &Parser::parse_string_literal;
+    table[token_index(TokenType::BANG)] = &Parser::parse_prefix_expression;
+    table[token_index(TokenType::MINUS)] = &Parser::parse_prefix_expression;
+    table[token_index(TokenType::TRUE)] = &Parser::parse_boolean;
+    table[token_index(TokenType::FALSE)] = &Parser::parse_boolean;
+    table[token_index(TokenType::LPAREN)] = &Parser::parse_grouped_expression;
+    table[token_index(TokenType::FUNCTION)] = &Parser::parse_function_literal;
+    table[token_index(TokenType::IF)] = &Parser::parse_if_expression;
+    return table;
+}();
+
+constexpr std::array<Parser::InfixParseFn, TOKEN_TYPE_COUNT> Parser::infix_parse_fns = [] {
+    std::array<InfixParseFn, TOKEN_TYPE_COUNT> table{};
+    for (TokenType type : {TokenType::PLUS, TokenType::MINUS, TokenType::SLASH, TokenType::ASTERISK,
+                           TokenType::EQ, TokenType::NOT_EQ, TokenType::LT, TokenType::GT}) {
+        table[token_index(type)] = &Parser::parse_infix_expression;
+    }
+    table[token_index(TokenType::LPAREN)] = &Parser::parse_call_expression;
+    table[token_index(TokenType::ASSIGN)] = &Parser::parse_assign_expression;
+    return table;
+}();
 
-    prefix_parse_fns[TokenType::IDENT] = [this]() { return parse_identifier(); };
-    prefix_parse_fns[TokenType::INT] = [this]() { return parse_integer_literal(); };
-    prefix_parse_fns[TokenType::BANG] = [this]() { return parse_prefix_expression(); };
-    prefix_parse_fns[TokenType::MINUS] = [this]() { return parse_prefix_expression(); };
-    prefix_parse_fns[TokenType::TRUE] = [this]() { return parse_boolean(); };
-    prefix_parse_fns[TokenType::FALSE] = [this]() { return parse_boolean(); };
-    prefix_parse_fns[TokenType::LPAREN] = [this]() { return parse_grouped_expression(); };
-    prefix_parse_fns[TokenType::FUNCTION] = [this]() { return parse_function_literal(); };
-    prefix_parse_fns[TokenType::IF] = [this]() { return parse_if_expression(); };
-
-    infix_parse_fns[TokenType::PLUS] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::MINUS] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::SLASH] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::ASTERISK] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::EQ] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::NOT_EQ] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::LT] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::GT] = [this](auto left) { return parse_infix_expression(std::move(left)); };
-    infix_parse_fns[TokenType::LPAREN] = [this](auto left) { return parse_call_expression(std::move(left)); };
+Parser::Parser(Lexer& l) : lexer(l) {
+    fill_tokens(0);
 }
 
-void Parser::next_token() {
-    current_token = peek_token;
-    peek_token = lexer.next_token();
+// Pide tokens al Lexer hasta tener index (todos si no es streaming)
+size_t Parser::fill_tokens(size_t index) {
+    while (index >= tokens.size() && !lexer_done) {
+        lexer_done = lexer.tokenize(tokens, lexer.streaming() ? 1 : SIZE_MAX);
+    }
+    return std::min(index, tokens.size() - 1);
 }
 
 bool Parser::expect_peek(TokenType t) {
-    if (peek_token.token_type == t) {
+    if (peek_token_is(t)) {
         next_token();
         return true;
     }
-    errors.push_back("Expected " + token_type_to_string(t) + ", got " + token_type_to_string(peek_token.token_type));
+    errors.push_back("Expected " + token_type_to_string(t) + ", got " + token_type_to_string(peek_type()));
     return false;
 }
 
 std::unique_ptr<Program> Parser::parse_program() {
-    auto program = std::make_unique<Program>();
-    while (current_token.token_type != TokenType::EOF_TOKEN) {
-        auto stmt = parse_statement();
+    auto program = make_node<Program>();
+    while (!at_eof()) {
+        auto stmt = next_statement();
         if (stmt) {
             program->statements.push_back(std::move(stmt));
         }
-        next_token();
     }
     return program;
 }
 
+std::unique_ptr<Statement> Parser::next_statement() {
+    auto stmt = parse_statement();
+    next_token();
+    if (stmt && closure_conversion) convert_closures(stmt.get());
+    // En streaming lo ya parseado no se vuelve a mirar
+    if (lexer.streaming() && cursor >= STREAM_DISCARD_TOKENS && cursor <= tokens.size()) {
+        tokens.discard_before(cursor);
+        cursor = 0;
+    }
+    return stmt;
+}
+
+bool Parser::at_eof() {
+    return cur_token_is(TokenType::EOF_TOKEN);
+}
+
 std::unique_ptr<Statement> Parser::parse_statement() {
-    if (current_token.token_type == TokenType::LET) {
+    if (cur_token_is(TokenType::LET)) {
         return parse_let_statement();
     }
-    if (current_token.token_type == TokenType::WHILE) {
+    if (cur_token_is(TokenType::WHILE)) {
         return parse_while_statement();
     }
+    if (cur_token_is(TokenType::FOR)) {
+        return parse_for_statement();
+    }
+    if (cur_token_is(TokenType::RETURN)) {
+        return parse_return_statement();
+    }
+    if (cur_token_is(TokenType::BREAK) || cur_token_is(TokenType::CONTINUE)) {
+        Token token = cur_token();
+        if (peek_token_is(TokenType::SEMICOLON)) next_token();
+        if (token.token_type == TokenType::BREAK) return make_node<BreakStatement>(token);
+        return make_node<ContinueStatement>(token);
+    }
     return parse_expression_statement();
 }
 
 std::unique_ptr<Statement> Parser::parse_expression_statement() {
-    Token token = current_token;
+    Token token = cur_token();
     auto expr = parse_expression(Precedence::LOWEST);
-    if (peek_token.token_type == TokenType::SEMICOLON) next_token();
-    return std::make_unique<ExpressionStatement>(token, std::move(expr));
+    if (peek_token_is(TokenType::SEMICOLON)) next_token();
+    return make_node<ExpressionStatement>(token, std::move(expr));
 }
 
 std::unique_ptr<Statement> Parser::parse_let_statement() {
-    Token let_token = current_token;
+    Token let_token = cur_token();
     if (!expect_peek(TokenType::IDENT)) return nullptr;
-    std::string name = current_token.literal;
+    std::string name(cur_literal());
     if (!expect_peek(TokenType::ASSIGN)) return nullptr;
     next_token();
     auto value = parse_expression(Precedence::LOWEST);
-    if (peek_token.token_type == TokenType::SEMICOLON) next_token();
-    return std::make_unique<LetStatement>(let_token, name, std::move(value));
+    if (peek_token_is(TokenType::SEMICOLON)) next_token();
+    return make_node<LetStatement>(let_token, name, std::move(value));
+}
+
+std::unique_ptr<Statement> Parser::parse_return_statement() {
+    Token token = cur_token();
+    std::unique_ptr<Expression> value;
+    if (!peek_token_is(TokenType::SEMICOLON) && !peek_token_is(TokenType::RBRACE) &&
+        !peek_token_is(TokenType::EOF_TOKEN)) {
+        next_token();
+        value = parse_expression(Precedence::LOWEST);
+    }
+    if (peek_token_is(TokenType::SEMICOLON)) next_token();
+    return make_node<ReturnStatement>(token, std::move(value));
 }
 
 std::unique_ptr<Statement> Parser::parse_while_statement() {
-    Token token = current_token;
+    Token token = cur_token();
     if (!expect_peek(TokenType::LPAREN)) return nullptr;
     next_token();
     auto condition = parse_expression(Precedence::LOWEST);
     if (!expect_peek(TokenType::RPAREN)) return nullptr;
     if (!expect_peek(TokenType::LBRACE)) return nullptr;
     auto body = parse_block_statement();
-    return std::make_unique<WhileStatement>(token, std::move(condition), std::move(body));
+    return make_node<WhileStatement>(token, std::move(condition), std::move(body));
+}
+
+// for (init; condición; actualización) { cuerpo }, con las tres partes opcionales
+std::unique_ptr<Statement> Parser::parse_for_statement() {
+    auto loop = make_node<ForStatement>(cur_token());
+    if (!expect_peek(TokenType::LPAREN)) return nullptr;
+    next_token();
+
+    if (!cur_token_is(TokenType::SEMICOLON)) {
+        loop->init = parse_statement();
+        // let y las expresiones ya consumen su ';'
+        if (!cur_token_is(TokenType::SEMICOLON) && !expect_peek(TokenType::SEMICOLON)) return nullptr;
+    }
+    next_token();
+
+    if (!cur_token_is(TokenType::SEMICOLON)) {
+        loop->condition = parse_expression(Precedence::LOWEST);
+        if (!expect_peek(TokenType::SEMICOLON)) return nullptr;
+    }
+    next_token();
+
+    if (!cur_token_is(TokenType::RPAREN)) {
+        loop->update = parse_statement();
+        if (!expect_peek(TokenType::RPAREN)) return nullptr;
+    }
+    if (!expect_peek(TokenType::LBRACE)) return nullptr;
+    loop->body = parse_block_statement();
+    loop->counted = analyze_counted_loop(loop.get());
+    return loop;
 }
 
 std::unique_ptr<BlockStatement> Parser::parse_block_statement() {
-    Token token = current_token;
+    Token token = cur_token();
     std::vector<std::unique_ptr<Statement>> statements;
     next_token();
-    while (current_token.token_type != TokenType::RBRACE &&
-           current_token.token_type != TokenType::EOF_TOKEN) {
+    while (!cur_token_is(TokenType::RBRACE) &&
+           !cur_token_is(TokenType::EOF_TOKEN)) {
         auto stmt = parse_statement();
         if (stmt) statements.push_back(std::move(stmt));
         next_token();
     }
-    auto block = std::make_unique<BlockStatement>(token);
+    number_values(statements);
+    auto block = make_node<BlockStatement>(token);
     block->statements = std::move(statements);
     return block;
 }
 
+// Preparseo: solo balancea llaves y copia los tokens con su posición, así
+// el Lexer del cuerpo los vuelve a ver en la misma línea y columna
+std::unique_ptr<BlockStatement> Parser::skip_function_body() {
+    auto block = make_node<BlockStatement>(cur_token());
+    auto lazy = std::make_unique<LazyBody>();
+    lazy->line = tokens.lines[token_at(1)];
+    uint32_t line = lazy->line;
+    uint32_t column = 1;
+    int depth = 1;
+    while (true) {
+        next_token();
+        size_t index = token_at(0);
+        TokenType type = tokens.types[index];
+        if (type == TokenType::EOF_TOKEN) {
+            errors.push_back("Falta '}' al final del cuerpo de la función");
+            break;
+        }
+        if (type == TokenType::LBRACE) ++depth;
+        if (type == TokenType::RBRACE && --depth == 0) break;
+
+        if (tokens.lines[index] > line) {
+            lazy->source.append(tokens.lines[index] - line, '\n');
+            line = tokens.lines[index];
+            column = 1;
+        }
+        if (tokens.columns[index] > column) {
+            lazy->source.append(tokens.columns[index] - column, ' ');
+            column = tokens.columns[index];
+        }
+        std::string_view literal = tokens.literal(index);
+        lazy->source += literal;
+        column += static_cast<uint32_t>(literal.size());
+    }
+    block->lazy = std::move(lazy);
+    return block;
+}
+
+bool parse_lazy_body(BlockStatement& body) {
+    LazyBody& lazy = *body.lazy;
+    std::call_once(lazy.parsed, [&body, &lazy]() {
+        Lexer lexer(lazy.source, lazy.line);
+        Parser parser(lexer);
+        // Sin los parámetros ni el let de la función no se puede saber qué es libre
+        parser.closure_conversion = false;
+        std::vector<std::unique_ptr<Statement>> statements;
+        while (!parser.at_eof()) {
+            auto stmt = parser.next_statement();
+            if (stmt) statements.push_back(std::move(stmt));
+        }
+        number_values(statements);
+        std::vector<std::string> errors = std::move(parser.errors);
+        if (errors.empty()) {
+            body.statements = std::move(statements);
+            body.frame_escapes = frame_escapes(&body);
+            errors = infer_function_body_types(&body);
+        }
+        if (!errors.empty()) {
+            std::cerr << "Errores en el cuerpo de la función (línea " << lazy.line << "):\n";
+            for (const auto& err : errors) {
+                std::cerr << "  - " << err << "\n";
+            }
+            body.statements.clear();
+            lazy.failed = true;
+        }
+    });
+    return !lazy.failed;
+}
+
 std::unique_ptr<Expression> Parser::parse_expression(Precedence precedence) {
-    auto prefix_fn = prefix_parse_fns.find(current_token.token_type);
-    if (prefix_fn == prefix_parse_fns.end()) return nullptr;
-    auto left = prefix_fn->second();
-    while (peek_token.token_type != TokenType::SEMICOLON &&
-           precedence < peek_precedence()) {
-        auto infix_fn = infix_parse_fns.find(peek_token.token_type);
-        if (infix_fn == infix_parse_fns.end()) break;
+    PrefixParseFn prefix_fn = prefix_parse_fns[token_index(cur_type())];
+    if (!prefix_fn) return nullptr;
+    auto left = (this->*prefix_fn)();
+    while (!peek_token_is(TokenType::SEMICOLON) && precedence < peek_precedence()) {
+        InfixParseFn infix_fn = infix_parse_fns[token_index(peek_type())];
+        if (!infix_fn) break;
         next_token();
-        left = infix_fn->second(std::move(left));
+        left = (this->*infix_fn)(std::move(left));
     }
     return left;
 }
 
 std::unique_ptr<Expression> Parser::parse_identifier() {
-    return std::make_unique<Identifier>(current_token, current_token.literal);
+    Token token = cur_token();
+    return make_node<Identifier>(token, token.literal);
 }
 
 std::unique_ptr<Expression> Parser::parse_integer_literal() {
-    int value = std::stoi(current_token.literal);
-    return std::make_unique<IntegerLiteral>(current_token, value);
+    Token token = cur_token();
+    int value = std::stoi(token.literal);
+    return make_node<IntegerLiteral>(token, value);
+}
+
+// El literal del token todavía tiene las comillas y los escapes (\n, \t, \" y \\)
+std::unique_ptr<Expression> Parser::parse_string_literal() {
+    Token token = cur_token();
+    std::string_view literal = token.literal;
+    std::string text;
+    size_t i = 1;
+    for (; i < literal.size() && literal[i] != '"'; ++i) {
+        if (literal[i] != '\\') {
+            text += literal[i];
+            continue;
+        }
+        if (++i == literal.size()) break;
+        switch (literal[i]) {
+            case 'n': text += '\n'; break;
+            case 't': text += '\t'; break;
+            case '"': text += '"'; break;
+            case '\\': text += '\\'; break;
+            default:
+                errors.push_back("Secuencia de escape inválida en la cadena " + token.literal);
+                return nullptr;
+        }
+    }
+    if (i >= literal.size()) {
+        errors.push_back("Cadena sin cerrar: " + token.literal);
+        return nullptr;
+    }
+    return make_node<StringLiteral>(token, make_string(text));
 }
 
 std::unique_ptr<Expression> Parser::parse_boolean() {
-    return std::make_unique<BooleanLiteral>(current_token, current_token.token_type == TokenType::TRUE);
+    return make_node<BooleanLiteral>(cur_token(), cur_token_is(TokenType::TRUE));
 }
 
 std::unique_ptr<Expression> Parser::parse_prefix_expression() {
-    Token token = current_token;
+    Token token = cur_token();
     std::string op = token.literal;
     next_token();
     auto right = parse_expression(Precedence::PREFIX);
-    return std::make_unique<PrefixExpression>(token, op, std::move(right));
+    return make_node<PrefixExpression>(token, op, std::move(right));
 }
 
 std::unique_ptr<Expression> Parser::parse_grouped_expression() {
@@ -150,28 +333,47 @@ std::unique_ptr<Expression> Parser::parse_grouped_expression() {
 }
 
 std::unique_ptr<Expression> Parser::parse_infix_expression(std::unique_ptr<Expression> left) {
-    Token token = current_token;
+    Token token = cur_token();
     std::string op = token.literal;
     Precedence precedence = cur_precedence();
     next_token();
     auto right = parse_expression(precedence);
-    return std::make_unique<InfixExpression>(token, std::move(left), op, std::move(right));
+    return make_node<InfixExpression>(token, std::move(left), op, std::move(right));
+}
+
+// Asociativa a derecha: a = b = 1 asigna 1 a las dos
+std::unique_ptr<Expression> Parser::parse_assign_expression(std::unique_ptr<Expression> left) {
+    Token token = cur_token();
+    auto target = dynamic_cast<Identifier*>(left.get());
+    if (!target) {
+        errors.push_back("Asignación inválida: se esperaba un identificador a la izquierda de '='");
+        return nullptr;
+    }
+    next_token();
+    auto value = parse_expression(Precedence::LOWEST);
+    return make_node<AssignExpression>(token, target->value, std::move(value));
 }
 
 std::unique_ptr<Expression> Parser::parse_function_literal() {
-    Token token = current_token;
+    Token token = cur_token();
     if (!expect_peek(TokenType::LPAREN)) return nullptr;
     auto parameters = parse_function_parameters();
     if (!expect_peek(TokenType::LBRACE)) return nullptr;
-    std::shared_ptr<BlockStatement> body(parse_block_statement().release());
-    auto function = std::make_unique<FunctionLiteral>(token);
+    std::shared_ptr<BlockStatement> body;
+    if (lazy_function_bodies) {
+        body.reset(skip_function_body().release());
+    } else {
+        body.reset(parse_block_statement().release());
+        body->frame_escapes = frame_escapes(body.get());
+    }
+    auto function = make_node<FunctionLiteral>(token);
     function->parameters = std::move(parameters);
     function->body = std::move(body);
     return function;
 }
 
 std::unique_ptr<Expression> Parser::parse_if_expression() {
-    Token token = current_token;
+    Token token = cur_token();
 
     if (!expect_peek(TokenType::LPAREN)) return nullptr;
     next_token();
@@ -185,27 +387,27 @@ std::unique_ptr<Expression> Parser::parse_if_expression() {
     auto consequence = parse_block_statement();
     if (!consequence) return nullptr;
 
-    auto if_expr = std::make_unique<IfExpression>(token);
+    auto if_expr = make_node<IfExpression>(token);
     if_expr->condition = std::move(condition);
     if_expr->consequence = std::move(consequence);
 
     // Manejar else y else if
-    if (peek_token.token_type == TokenType::ELSE) {
+    if (peek_token_is(TokenType::ELSE)) {
         next_token();
 
         // Si después de else viene if, parseamos otra if expression
-        if (peek_token.token_type == TokenType::IF) {
+        if (peek_token_is(TokenType::IF)) {
             next_token();
             // Recursivamente parsear otra if expression para else if
             auto else_if = parse_if_expression();
             if (else_if) {
                 // Convertir la if expression a un block statement
-                auto else_block = std::make_unique<BlockStatement>(Token(TokenType::LBRACE, "{"));
-                auto else_stmt = std::make_unique<ExpressionStatement>(else_if->get_token(), std::move(else_if));
+                auto else_block = make_node<BlockStatement>(Token(TokenType::LBRACE, "{", else_if->line, else_if->column));
+                auto else_stmt = make_node<ExpressionStatement>(else_if->get_token(), std::move(else_if));
                 else_block->statements.push_back(std::move(else_stmt));
                 if_expr->alternative = std::move(else_block);
             }
-        } else if (peek_token.token_type == TokenType::LBRACE) {
+        } else if (peek_token_is(TokenType::LBRACE)) {
             // Else normal con bloque
             next_token();
             if_expr->alternative = parse_block_statement();
@@ -217,49 +419,47 @@ std::unique_ptr<Expression> Parser::parse_if_expression() {
 
 std::vector<std::string> Parser::parse_function_parameters() {
     std::vector<std::string> identifiers;
-    if (peek_token.token_type == TokenType::RPAREN) {
+    if (peek_token_is(TokenType::RPAREN)) {
         next_token();
         return identifiers;
     }
     next_token();
-    identifiers.push_back(current_token.literal);
-    while (peek_token.token_type == TokenType::COMMA) {
+    identifiers.emplace_back(cur_literal());
+    while (peek_token_is(TokenType::COMMA)) {
         next_token();
         next_token();
-        identifiers.push_back(current_token.literal);
+        identifiers.emplace_back(cur_literal());
     }
     if (!expect_peek(TokenType::RPAREN)) return {};
     return identifiers;
 }
 
 std::unique_ptr<Expression> Parser::parse_call_expression(std::unique_ptr<Expression> function) {
-    Token token = current_token;
+    Token token = cur_token();
     std::vector<std::unique_ptr<Expression>> args;
-    if (peek_token.token_type != TokenType::RPAREN) {
+    if (!peek_token_is(TokenType::RPAREN)) {
         next_token();
         args.push_back(parse_expression(Precedence::LOWEST));
-        while (peek_token.token_type == TokenType::COMMA) {
+        while (peek_token_is(TokenType::COMMA)) {
             next_token();
             next_token();
             args.push_back(parse_expression(Precedence::LOWEST));
         }
     }
     if (!expect_peek(TokenType::RPAREN)) return nullptr;
-    auto call = std::make_unique<CallExpression>(token, std::move(function));
+    auto call = make_node<CallExpression>(token, std::move(function));
     call->arguments = std::move(args);
     return call;
 }
 
 Precedence Parser::peek_precedence() {
-    return get_precedence(peek_token.token_type);
+    return get_precedence(peek_type());
 }
 
 Precedence Parser::cur_precedence() {
-    return get_precedence(current_token.token_type);
+    return get_precedence(cur_type());
 }
 
 Precedence Parser::get_precedence(TokenType type) {
-    auto it = precedences.find(type);
-    if (it != precedences.end()) return it->second;
-    return Precedence::LOWEST;
-}
\ No newline at end of file
+    return precedences[token_index(type)];
+}
@@ -3,8 +3,7 @@
 
 #include <vector>
 #include <memory>
-#include <unordered_map>
-#include <functional>
+#include <array>
 #include "lexer.h"
 #include "ast.h"
 
@@ -19,51 +18,106 @@ enum class Precedence {
     CALL         // myFunction(X)
 };
 
-inline std::unordered_map<TokenType, Precedence> precedences = {
-    {TokenType::EQ, Precedence::EQUALS},
-    {TokenType::NOT_EQ, Precedence::EQUALS},
-    {TokenType::LT, Precedence::LESSGREATER},
-    {TokenType::GT, Precedence::LESSGREATER},
-    {TokenType::PLUS, Precedence::SUM},
-    {TokenType::MINUS, Precedence::SUM},
-    {TokenType::SLASH, Precedence::PRODUCT},
-    {TokenType::ASTERISK, Precedence::PRODUCT},
-    {TokenType::LPAREN, Precedence::CALL},
-};
+inline constexpr auto precedences = [] {
+    std::array<Precedence, TOKEN_TYPE_COUNT> table{};   // LOWEST para el resto
+    table[token_index(TokenType::ASSIGN)] = Precedence::ASSIGN;
+    table[token_index(TokenType::EQ)] = Precedence::EQUALS;
+    table[token_index(TokenType::NOT_EQ)] = Precedence::EQUALS;
+    table[token_index(TokenType::LT)] = Precedence::LESSGREATER;
+    table[token_index(TokenType::GT)] = Precedence::LESSGREATER;
+    table[token_index(TokenType::PLUS)] = Precedence::SUM;
+    table[token_index(TokenType::MINUS)] = Precedence::SUM;
+    table[token_index(TokenType::SLASH)] = Precedence::PRODUCT;
+    table[token_index(TokenType::ASTERISK)] = Precedence::PRODUCT;
+    table[token_index(TokenType::LPAREN)] = Precedence::CALL;
+    return table;
+}();
 
 class Parser {
 public:
     explicit Parser(Lexer& lexer);
     std::unique_ptr<Program> parse_program();
+    // Parseo incremental: devuelve la siguiente sentencia de nivel superior
+    // apenas está completa (nullptr si tuvo errores). Ver at_eof().
+    std::unique_ptr<Statement> next_statement();
+    bool at_eof();
     std::vector<std::string> errors;
 
+    // Los cuerpos de función se guardan como texto y se parsean en su primera
+    // llamada (ver LazyBody). Pensado para preludios con muchas funciones
+    // que cada script usa pocas veces; los errores de esos cuerpos aparecen
+    // recién al llamarlas.
+    bool lazy_function_bodies = false;
+
+    // Cada sentencia de nivel superior pasa por convert_closures (ver
+    // closure_conversion.h)
+    bool closure_conversion = true;
+
 private:
     Lexer& lexer;
-    Token current_token;
-    Token peek_token;
+    // Con un fuente completo el Lexer llena tokens de una vez en el
+    // constructor; en streaming se piden a medida que hacen falta
+    TokenBuffer tokens;
+    size_t cursor = 0;   // token actual
+    bool lexer_done = false;
+
+    // Cada cuántos tokens consumidos se compacta el buffer en streaming
+    static constexpr size_t STREAM_DISCARD_TOKENS = 4096;
+
+    // Tablas de Pratt indexadas por TokenType (nullptr: sin función)
+    using PrefixParseFn = std::unique_ptr<Expression> (Parser::*)();
+    using InfixParseFn = std::unique_ptr<Expression> (Parser::*)(std::unique_ptr<Expression>);
 
-    using PrefixParseFn = std::function<std::unique_ptr<Expression>()>;
-    using InfixParseFn = std::function<std::unique_ptr<Expression>(std::unique_ptr<Expression>)>;
+    static const std::array<PrefixParseFn, TOKEN_TYPE_COUNT> prefix_parse_fns;
+    static const std::array<InfixParseFn, TOKEN_TYPE_COUNT> infix_parse_fns;
 
-    std::unordered_map<TokenType, PrefixParseFn> prefix_parse_fns;
-    std::unordered_map<TokenType, InfixParseFn> infix_parse_fns;
+    // Posición en tokens del token ahead lugares después del actual; pasado
+    // el final queda en el EOF, como el Lexer que lo repetía
+    size_t token_at(size_t ahead) {
+        size_t index = cursor + ahead;
+        return index < tokens.size() ? index : fill_tokens(index);
+    }
+    size_t fill_tokens(size_t index);
 
-    void next_token();
+    TokenType cur_type() { return tokens.types[token_at(0)]; }
+    TokenType peek_type(size_t ahead = 1) { return tokens.types[token_at(ahead)]; }
+    std::string_view cur_literal() { return tokens.literal(token_at(0)); }
+    Token cur_token() { return tokens.token(token_at(0)); }
+
+    // Crea un nodo con la posición de su token y lo anota en el perfil de
+    // memoria (ver alloc_profiler.h)
+    template <typename T, typename... Args>
+    std::unique_ptr<T> make_node(Args&&... args) {
+        auto node = std::make_unique<T>(std::forward<Args>(args)...);
+        if constexpr (requires { node->token; }) {
+            node->line = node->token.line;
+            node->column = node->token.column;
+        }
+        profile_allocation_at(node.get(), typeid(T), sizeof(T), node->line, node->column);
+        return node;
+    }
+
+    void next_token() { ++cursor; }
     bool expect_peek(TokenType t);
-    bool cur_token_is(TokenType t);
-    bool peek_token_is(TokenType t);
+    bool cur_token_is(TokenType t) { return cur_type() == t; }
+    bool peek_token_is(TokenType t) { return peek_type() == t; }
 
     std::unique_ptr<Statement> parse_statement();
     std::unique_ptr<Statement> parse_let_statement();
     std::unique_ptr<Statement> parse_while_statement();
+    std::unique_ptr<Statement> parse_return_statement();
+    std::unique_ptr<Statement> parse_for_statement();
     std::unique_ptr<BlockStatement> parse_block_statement();
+    std::unique_ptr<BlockStatement> skip_function_body();
     std::unique_ptr<Statement> parse_expression_statement();
 
     std::unique_ptr<Expression> parse_expression(Precedence precedence);
     std::unique_ptr<Expression> parse_identifier();
     std::unique_ptr<Expression> parse_integer_literal();
+    std::unique_ptr<Expression> parse_string_literal();
     std::unique_ptr<Expression> parse_prefix_expression();
     std::unique_ptr<Expression> parse_infix_expression(std::unique_ptr<Expression> left);
+    std::unique_ptr<Expression> parse_assign_expression(std::unique_ptr<Expression> left);
     std::unique_ptr<Expression> parse_grouped_expression();
     std::unique_ptr<Expression> parse_function_literal();
     std::unique_ptr<Expression> parse_call_expression(std::unique_ptr<Expression> function);
@@ -77,4 +131,12 @@ private:
     Precedence get_precedence(TokenType type);
 };
 
+// Arma el AST de un cuerpo diferido, una sola vez aunque lo llamen varios
+// hilos. false si tiene errores (ya informados).
+bool parse_lazy_body(BlockStatement& body);
+
+inline bool ensure_parsed(BlockStatement& body) {
+    return !body.lazy || parse_lazy_body(body);
+}
+
 #endif
\ No newline at end of file
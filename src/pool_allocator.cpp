@@ -0,0 +1,130 @@
+#include "pool_allocator.h"
+#include <cstdlib>
+#include <mutex>
+
+namespace pool_detail {
+
+namespace {
+
+constexpr size_t SLAB_BYTES = 64 * 1024;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Bloques libres de hilos que ya terminaron. No se destruye nunca: otros
+// objetos estáticos pueden devolver bloques durante la salida del programa.
+struct OrphanLists {
+    std::mutex mutex;
+    FreeBlock* heads[SIZE_CLASSES] = {};
+};
+
+OrphanLists& orphans() {
+    static OrphanLists* lists = new OrphanLists();
+    return *lists;
+}
+
+// Trivialmente destructible a propósito: sigue siendo válido mientras se
+// destruyen los demás thread_local del hilo (FrameStack, entornos, ...)
+struct ThreadPool {
+    FreeBlock* heads[SIZE_CLASSES];
+    PoolStats stats;
+    bool registered;
+    bool exited;
+};
+
+thread_local ThreadPool pool = {};
+
+void push_orphans(size_t size_class, FreeBlock* head) {
+    if (!head) return;
+    FreeBlock* tail = head;
+    while (tail->next) tail = tail->next;
+    OrphanLists& global = orphans();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    tail->next = global.heads[size_class];
+    global.heads[size_class] = head;
+}
+
+// Al terminar el hilo, sus bloques libres pasan a la lista global. Lo que se
+// libere después en este hilo va directo a la lista global.
+struct ThreadExit {
+    ~ThreadExit() {
+        for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+            push_orphans(i, pool.heads[i]);
+            pool.heads[i] = nullptr;
+        }
+        pool.exited = true;
+    }
+};
+
+// La primera vez que el hilo toma o devuelve un bloque: un hilo que solo
+// libera objetos creados en otro también tiene que pasar su lista al salir
+void register_thread_exit() {
+    if (pool.registered) return;
+    pool.registered = true;
+    thread_local ThreadExit on_exit;
+    (void)on_exit;
+}
+
+// Adopta los bloques huérfanos de la clase, o reserva un slab nuevo.
+// Los slabs no se devuelven nunca: sus bloques pueden seguir vivos en
+// cualquier hilo.
+void refill(size_t size_class) {
+    register_thread_exit();
+
+    OrphanLists& global = orphans();
+    {
+        std::lock_guard<std::mutex> lock(global.mutex);
+        if (global.heads[size_class]) {
+            pool.heads[size_class] = global.heads[size_class];
+            global.heads[size_class] = nullptr;
+            return;
+        }
+    }
+
+    size_t block_size = (size_class + 1) * GRANULE;
+    char* slab = static_cast<char*>(std::malloc(SLAB_BYTES));
+    if (!slab) throw std::bad_alloc();
+    ++pool.stats.slabs;
+
+    FreeBlock* head = nullptr;
+    for (size_t offset = SLAB_BYTES - SLAB_BYTES % block_size; offset >= block_size; offset -= block_size) {
+        auto block = reinterpret_cast<FreeBlock*>(slab + offset - block_size);
+        block->next = head;
+        head = block;
+    }
+    pool.heads[size_class] = head;
+}
+
+} // namespace
+
+void* allocate(size_t size_class) {
+    ++pool.stats.allocations;
+    if (pool.heads[size_class]) {
+        ++pool.stats.reused;
+    } else {
+        refill(size_class);
+    }
+    FreeBlock* block = pool.heads[size_class];
+    pool.heads[size_class] = block->next;
+    return block;
+}
+
+void release(void* block, size_t size_class) {
+    ++pool.stats.releases;
+    auto free_block = static_cast<FreeBlock*>(block);
+    if (pool.exited) {
+        free_block->next = nullptr;
+        push_orphans(size_class, free_block);
+        return;
+    }
+    register_thread_exit();
+    free_block->next = pool.heads[size_class];
+    pool.heads[size_class] = free_block;
+}
+
+} // namespace pool_detail
+
+PoolStats& pool_stats() {
+    return pool_detail::pool.stats;
+}
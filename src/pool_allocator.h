@@ -0,0 +1,80 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Asignador por clases de tamaño para los objetos del runtime que se crean y
+// destruyen en cada llamada (Environment, Function, nodos de sus tablas).
+// Cada hilo tiene su lista libre por clase: pedir y devolver un bloque no
+// toma locks ni pasa por malloc salvo cuando hay que reservar un slab nuevo.
+// Un bloque liberado en otro hilo queda en la lista de ese hilo; al terminar
+// un hilo sus bloques libres pasan a una lista global que reutilizan los demás.
+
+struct PoolStats {
+    size_t allocations = 0;   // bloques entregados
+    size_t reused = 0;        // de ellos, sacados de una lista libre
+    size_t releases = 0;      // bloques devueltos
+    size_t slabs = 0;         // slabs reservados con malloc
+    size_t oversized = 0;     // pedidos demasiado grandes, van a operator new
+};
+
+// Contadores del hilo actual
+PoolStats& pool_stats();
+
+namespace pool_detail {
+
+constexpr size_t GRANULE = 16;
+constexpr size_t SIZE_CLASSES = 16;   // bloques de 16 a 256 bytes
+constexpr size_t MAX_BLOCK = GRANULE * SIZE_CLASSES;
+
+constexpr size_t size_class(size_t bytes) {
+    return bytes == 0 ? 0 : (bytes - 1) / GRANULE;
+}
+
+void* allocate(size_t size_class);
+void release(void* block, size_t size_class);
+
+} // namespace pool_detail
+
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes > pool_detail::MAX_BLOCK || alignof(T) > pool_detail::GRANULE) {
+            ++pool_stats().oversized;
+            return static_cast<T*>(::operator new(bytes));
+        }
+        return static_cast<T*>(pool_detail::allocate(pool_detail::size_class(bytes)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        size_t bytes = n * sizeof(T);
+        if (bytes > pool_detail::MAX_BLOCK || alignof(T) > pool_detail::GRANULE) {
+            ::operator delete(p);
+            return;
+        }
+        pool_detail::release(p, pool_detail::size_class(bytes));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+// Como make_shared, pero el objeto y su bloque de control salen del pool
+template <typename T, typename... Args>
+std::shared_ptr<T> make_pooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+#endif // POOL_ALLOCATOR_H
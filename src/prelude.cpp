@@ -0,0 +1,49 @@
+#include "prelude.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "evaluator.h"
+#include "parallel_parser.h"
+#include "type_inference.h"
+#include "inlining.h"
+
+bool read_source_file(const std::string& path, std::string& out) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "No se pudo abrir " << path << "\n";
+        return false;
+    }
+    std::stringstream source;
+    source << input.rdbuf();
+    out = source.str();
+    return true;
+}
+
+bool load_prelude(const std::string& path, const std::shared_ptr<Environment>& env) {
+    std::string source;
+    if (!read_source_file(path, source)) return false;
+
+    // Casi ninguna función del preludio se llama en cada script: sus
+    // cuerpos se parsean recién al usarlas
+    std::vector<std::string> parse_errors;
+    auto program = parse_source(source, parse_errors, true);
+    if (!parse_errors.empty()) {
+        std::cerr << "Errores de parsing en " << path << ":\n";
+        for (const auto& err : parse_errors) {
+            std::cerr << "  - " << err << "\n";
+        }
+        return false;
+    }
+    auto type_errors = infer_types(program.get(), env);
+    if (!type_errors.empty()) {
+        std::cerr << "Errores de tipos en " << path << ":\n";
+        for (const auto& err : type_errors) {
+            std::cerr << "  - " << err << "\n";
+        }
+        return false;
+    }
+    inline_calls(program.get(), env);
+
+    eval(program.get(), env);
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef PRELUDE_H
+#define PRELUDE_H
+
+#include <memory>
+#include <string>
+#include "environment.h"
+
+// Lee un archivo completo. Devuelve false (y reporta) si no se pudo abrir.
+bool read_source_file(const std::string& path, std::string& out);
+
+// Parsea y evalúa un archivo de preludio sobre env, que queda con sus
+// definiciones. Devuelve false si hubo errores de lectura o de parsing.
+bool load_prelude(const std::string& path, const std::shared_ptr<Environment>& env);
+
+#endif // PRELUDE_H
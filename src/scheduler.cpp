@@ -0,0 +1,177 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "environment.h"
+#include "parser.h"
+#include "stackless_evaluator.h"
+
+// Índice del trabajador que corre en este hilo (-1 fuera del scheduler)
+static thread_local int worker_index = -1;
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler(std::max(1u, std::thread::hardware_concurrency()));
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() { worker_main(i); });
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void TaskScheduler::submit(Job job) {
+    WorkQueue& queue = worker_index >= 0 ? *queues[worker_index] : injected;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        ++queued;
+    }
+    idle.notify_one();
+}
+
+bool TaskScheduler::take(WorkQueue& queue, bool from_back, Job& job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    if (from_back) {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    } else {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    }
+    --queued;
+    return true;
+}
+
+bool TaskScheduler::run_one() {
+    Job job;
+    bool found = worker_index >= 0 && take(*queues[worker_index], true, job);
+    if (!found) found = take(injected, false, job);
+    // Robo: se recorren las colas ajenas empezando por la siguiente a la
+    // propia, para que los ladrones no se amontonen sobre la primera
+    size_t start = worker_index >= 0 ? static_cast<size_t>(worker_index) + 1 : 0;
+    for (size_t i = 0; !found && i < queues.size(); ++i) {
+        found = take(*queues[(start + i) % queues.size()], false, job);
+    }
+    if (!found) return false;
+    job();
+    return true;
+}
+
+void TaskScheduler::worker_main(size_t index) {
+    worker_index = static_cast<int>(index);
+    while (true) {
+        if (run_one()) continue;
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void Task::complete(std::shared_ptr<Object> result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        value = std::move(result);
+        finished = true;
+    }
+    finished_signal.notify_all();
+}
+
+std::shared_ptr<Object> Task::wait() {
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (finished) return value;
+        }
+        if (scheduler.run_one()) continue;
+        // Nada para ayudar: la tarea corre en otro hilo. Se vuelve a mirar
+        // la cola cada tanto por si aparece trabajo nuevo.
+        std::unique_lock<std::mutex> lock(mutex);
+        finished_signal.wait_for(lock, std::chrono::milliseconds(1), [this]() { return finished; });
+    }
+}
+
+namespace {
+
+// Copia del grafo de entornos alcanzable desde una función, para que la
+// tarea no comparta nada mutable con quien la lanzó. Solo se copian los
+// stores propios: los entornos sellados (un preludio, ver Environment::seal)
+// y las capas congeladas de los demás no cambian nunca, así que se comparten
+// y el costo de spawn no crece con el preludio. Los enteros, booleanos,
+// null, cadenas y builtins también se comparten: nadie los modifica mientras
+// haya más de una referencia (ver assign_in_place). Los cuerpos (AST)
+// también, son de solo lectura al evaluar.
+class HeapCopy {
+public:
+    std::shared_ptr<Object> value(const std::shared_ptr<Object>& original) {
+        if (!original || original->type() != ObjectType::FUNCTION_OBJ) return original;
+        auto func = static_cast<const Function*>(original.get());
+        if (!func->env || func->env->is_sealed()) return original;
+        auto it = functions.find(original.get());
+        if (it != functions.end()) return it->second;
+
+        auto copy = make_pooled<Function>(func->parameters, func->body, nullptr);
+        functions.emplace(original.get(), copy);
+        copy->env = environment(func->env);
+        return copy;
+    }
+
+    std::shared_ptr<Environment> environment(const std::shared_ptr<Environment>& original) {
+        if (!original || original->is_sealed()) return original;
+        auto it = environments.find(original.get());
+        if (it != environments.end()) return it->second;
+
+        // Se registra antes de recorrer: los ciclos (una función ligada en
+        // su propio entorno) vuelven a esta misma copia
+        auto copy = make_pooled<Environment>();
+        environments.emplace(original.get(), copy);
+        copy->reset(environment(original->outer_env()));
+        copy->share_layers(*original);
+        for (const auto& [name, binding] : original->own_bindings()) {
+            copy->set(name, value(binding));
+        }
+        return copy;
+    }
+
+private:
+    std::unordered_map<const Object*, std::shared_ptr<Function>> functions;
+    std::unordered_map<const Environment*, std::shared_ptr<Environment>> environments;
+};
+
+} // namespace
+
+std::shared_ptr<Task> spawn_task(const std::shared_ptr<Function>& func) {
+    // La copia se hace en el hilo que lanza, el único que toca esos entornos
+    auto isolated = std::static_pointer_cast<Function>(HeapCopy().value(func));
+    auto task = std::make_shared<Task>();
+    TaskScheduler::instance().submit([task, isolated]() {
+        // Sin pila nativa: una recursión profunda no depende del hilo trabajador
+        if (!ensure_parsed(*isolated->body)) {
+            task->complete(nullptr);
+            return;
+        }
+        StacklessEvaluator evaluator;
+        auto call_env = make_pooled<Environment>(isolated->env);
+        task->complete(evaluator.eval(isolated->body.get(), call_env));
+    });
+    return task;
+}
@@ -0,0 +1,82 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "object.h"
+
+// Scheduler de tareas con robo de trabajo (spawn/join, ver builtins.h).
+// Cada hilo trabajador tiene su propia cola: encola y saca del final (lo
+// último que creó, todavía caliente en caché) y, si se queda sin trabajo,
+// roba del principio de la cola de otro. Lo que llega desde hilos que no
+// son del scheduler entra por una cola compartida.
+class TaskScheduler {
+public:
+    using Job = std::function<void()>;
+
+    // Scheduler del proceso; arranca un trabajador por núcleo en el primer uso
+    static TaskScheduler& instance();
+
+    explicit TaskScheduler(size_t threads);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(Job job);
+
+    // Corre un trabajo pendiente en el hilo actual (propio, compartido o
+    // robado). false si no había ninguno.
+    bool run_one();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;   // una por trabajador
+    WorkQueue injected;                              // desde hilos de afuera
+    std::vector<std::thread> workers;
+
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    void worker_main(size_t index);
+    bool take(WorkQueue& queue, bool from_back, Job& job);
+};
+
+// Resultado de un spawn. join espera con wait(), que mientras tanto corre
+// otras tareas del scheduler en vez de bloquear el hilo.
+class Task : public Object {
+public:
+    Task() { profile_allocation(this, typeid(Task), sizeof(Task)); }
+    ObjectType type() const override { return ObjectType::TASK_OBJ; }
+    std::string inspect() const override { return "task"; }
+
+    void complete(std::shared_ptr<Object> value);
+    std::shared_ptr<Object> wait();
+
+private:
+    std::mutex mutex;
+    std::condition_variable finished_signal;
+    bool finished = false;
+    std::shared_ptr<Object> value;   // nullptr si la tarea terminó con error
+};
+
+// Agenda func() (sin parámetros) en el scheduler. La tarea corre sobre una
+// copia propia de los entornos que alcanza func, así que no comparte nada
+// mutable con quien la lanzó: sus asignaciones a variables exteriores no se
+// ven afuera, y solo el valor de retorno vuelve por join. La copia cuesta
+// lo que el grafo de entornos; está pensado para tareas gruesas.
+std::shared_ptr<Task> spawn_task(const std::shared_ptr<Function>& func);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,264 @@
+#include "server.h"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "lexer.h"
+#include "parser.h"
+#include "stackless_evaluator.h"
+#include "type_inference.h"
+#include "inlining.h"
+
+static std::atomic<int> active_listen_fd{-1};
+
+static void handle_stop_signal(int) {
+    int fd = active_listen_fd.load();
+    if (fd >= 0) {
+        // Despierta al accept() bloqueado
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+static uint64_t micros_between(std::chrono::steady_clock::time_point from,
+                               std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+size_t LatencyStats::bucket_for(uint64_t value) {
+    if (value < SUB_BUCKETS) return value;
+    unsigned exponent = std::bit_width(value) - 1;   // >= 4
+    size_t sub = (value >> (exponent - 4)) & (SUB_BUCKETS - 1);
+    return (exponent - 3) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyStats::bucket_limit(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    unsigned exponent = static_cast<unsigned>(bucket / SUB_BUCKETS) + 3;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (exponent - 4)) - 1;
+}
+
+void LatencyStats::record(uint64_t parse_us, uint64_t eval_us, uint64_t total_us) {
+    std::lock_guard<std::mutex> lock(mutex);
+    buckets[bucket_for(total_us)]++;
+    count++;
+    total_sum += total_us;
+    total_max = std::max(total_max, total_us);
+    parse_sum += parse_us;
+    eval_sum += eval_us;
+}
+
+// Con el mutex tomado. El límite del bucket donde cae el request de ese
+// rango, sin pasarse del máximo visto.
+uint64_t LatencyStats::percentile(double p) const {
+    auto rank = static_cast<uint64_t>(p * static_cast<double>(count - 1));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += buckets[bucket];
+        if (seen > rank) return std::min(bucket_limit(bucket), total_max);
+    }
+    return total_max;
+}
+
+std::string LatencyStats::summary() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+    out << "requests=" << count;
+    if (count == 0) return out.str();
+
+    out << " total_us(media=" << total_sum / count
+        << " p50=" << percentile(0.50)
+        << " p99=" << percentile(0.99)
+        << " max=" << total_max << ")"
+        << " parse_us_media=" << parse_sum / count
+        << " eval_us_media=" << eval_sum / count;
+    return out.str();
+}
+
+ScriptServer::ScriptServer(ServerOptions opts, std::shared_ptr<Environment> prelude)
+    : options(std::move(opts)), prelude_env(std::move(prelude)) {
+    // Los workers forkean el preludio a la vez: queda sellado de antemano
+    prelude_env->seal();
+}
+
+ScriptServer::~ScriptServer() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(options.socket_path.c_str());
+    }
+}
+
+int ScriptServer::run() {
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Ruta de socket demasiado larga: " << options.socket_path << "\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, options.socket_path.c_str());
+    unlink(options.socket_path.c_str());
+
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 128) < 0) {
+        std::cerr << "No se pudo escuchar en " << options.socket_path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    active_listen_fd = listen_fd;
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+
+    for (size_t i = 0; i < std::max<size_t>(options.workers, 1); ++i) {
+        workers.emplace_back([this]() { worker_main(); });
+    }
+    std::cerr << "Escuchando en " << options.socket_path << " con " << workers.size() << " workers\n";
+
+    while (true) {
+        int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;   // socket cerrado por la señal de parada
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            pending_connections.push_back(client);
+        }
+        queue_ready.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    active_listen_fd = -1;
+
+    std::cerr << "Servidor detenido: " << stats.summary() << "\n";
+    return 0;
+}
+
+void ScriptServer::worker_main() {
+    while (true) {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [this]() { return stopping || !pending_connections.empty(); });
+            if (pending_connections.empty()) return;
+            fd = pending_connections.front();
+            pending_connections.pop_front();
+        }
+        handle_connection(fd);
+    }
+}
+
+void ScriptServer::handle_connection(int fd) {
+    // Cada read (y cada write) espera a lo sumo read_timeout_ms, y el request
+    // completo tampoco puede tardar más: si no, un cliente que manda de a un
+    // byte retendría el worker igual
+    timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(options.read_timeout_ms / 1000);
+    timeout.tv_usec = static_cast<suseconds_t>(options.read_timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.read_timeout_ms);
+
+    std::string source;
+    std::string error;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if ((n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) || std::chrono::steady_clock::now() > deadline) {
+            error = "Error: se agotó el tiempo de espera del request (" +
+                    std::to_string(options.read_timeout_ms) + " ms)\n";
+            break;
+        }
+        if (n <= 0) break;
+        if (source.size() + static_cast<size_t>(n) > options.max_request_bytes) {
+            error = "Error: el request supera el máximo de " + std::to_string(options.max_request_bytes) + " bytes\n";
+            // El resto no se lee: el cliente ve fallar su envío, pero la
+            // respuesta con el error le llega igual
+            shutdown(fd, SHUT_RD);
+            break;
+        }
+        source.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string response;
+    if (!error.empty()) {
+        response = error;
+    } else if (source == ":stats" || source == ":stats\n") {
+        response = stats.summary() + "\n";
+    } else {
+        response = evaluate_request(source);
+    }
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = write(fd, response.data() + sent, response.size() - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+    close(fd);
+}
+
+std::string ScriptServer::evaluate_request(const std::string& source) {
+    auto start = std::chrono::steady_clock::now();
+
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse_program();
+    auto parsed = std::chrono::steady_clock::now();
+
+    std::ostringstream out;
+    std::vector<std::string> type_errors;
+    if (parser.errors.empty()) type_errors = infer_types(program.get(), prelude_env);
+    if (!parser.errors.empty()) {
+        out << "Errores de parsing:\n";
+        for (const auto& err : parser.errors) {
+            out << "  - " << err << "\n";
+        }
+    } else if (!type_errors.empty()) {
+        out << "Errores de tipos:\n";
+        for (const auto& err : type_errors) {
+            out << "  - " << err << "\n";
+        }
+    } else {
+        // Aislamiento: los let del script quedan en su propia copia del preludio
+        auto request_env = prelude_env->fork();
+        inline_calls(program.get(), prelude_env);
+        StacklessEvaluator evaluator;
+        auto result = evaluator.eval(program.get(), request_env);
+        if (result) {
+            out << "Resultado: " << result->inspect() << "\n";
+        } else {
+            out << "Resultado nulo o error de ejecución.\n";
+        }
+    }
+    auto finished = std::chrono::steady_clock::now();
+
+    uint64_t parse_us = micros_between(start, parsed);
+    uint64_t eval_us = micros_between(parsed, finished);
+    uint64_t total_us = micros_between(start, finished);
+    stats.record(parse_us, eval_us, total_us);
+    out << "# parse_us=" << parse_us << " eval_us=" << eval_us << " total_us=" << total_us << "\n";
+    return out.str();
+}
@@ -0,0 +1,84 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "environment.h"
+
+struct ServerOptions {
+    std::string socket_path;
+    size_t workers = 4;
+    // Un cliente que no termina de mandar su script no retiene un worker
+    // más que esto, y un script no puede ocupar más que max_request_bytes
+    unsigned read_timeout_ms = 5000;
+    size_t max_request_bytes = 1 << 20;
+};
+
+// Latencias por request (microsegundos), para el resumen del servidor.
+// Memoria fija aunque el servidor atienda millones de requests: los totales
+// van a un histograma log-lineal (16 buckets por potencia de dos, error
+// relativo menor a 1/16) y p50/p99 salen de ahí.
+class LatencyStats {
+public:
+    void record(uint64_t parse_us, uint64_t eval_us, uint64_t total_us);
+    std::string summary() const;
+
+private:
+    static constexpr unsigned SUB_BUCKETS = 16;
+    // Valores < 16 exactos; después 16 por cada potencia de dos hasta 2^63
+    static constexpr size_t BUCKETS = (64 - 3) * SUB_BUCKETS;
+
+    static size_t bucket_for(uint64_t value);
+    // Mayor valor que cae en el bucket
+    static uint64_t bucket_limit(size_t bucket);
+    uint64_t percentile(double p) const;
+
+    mutable std::mutex mutex;
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t total_sum = 0;
+    uint64_t total_max = 0;
+    uint64_t parse_sum = 0;
+    uint64_t eval_sum = 0;
+};
+
+// Servidor de larga vida sobre un socket Unix. Cada conexión manda un
+// script y cierra su lado de escritura; la respuesta trae el resultado y
+// una línea con la latencia. Los scripts corren en un pool de hilos, cada
+// uno en un entorno propio encima del preludio ya evaluado, que se comparte
+// en solo lectura. Un request con el texto ":stats" devuelve el resumen de
+// latencias.
+class ScriptServer {
+public:
+    ScriptServer(ServerOptions options, std::shared_ptr<Environment> prelude_env);
+    ~ScriptServer();
+
+    // Atiende conexiones hasta recibir SIGINT o SIGTERM
+    int run();
+
+private:
+    ServerOptions options;
+    std::shared_ptr<Environment> prelude_env;
+    LatencyStats stats;
+
+    int listen_fd = -1;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<int> pending_connections;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void worker_main();
+    void handle_connection(int fd);
+    std::string evaluate_request(const std::string& source);
+};
+
+#endif // SERVER_H
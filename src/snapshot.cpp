@@ -0,0 +1,632 @@
+#include "snapshot.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ast.h"
+#include "builtins.h"
+#include "induction.h"
+#include "parser.h"
+#include "string_object.h"
+
+// Formato (enteros little-endian de 32 bits, strings con largo delante):
+//   "CCSNAP03"
+//   cantidad de entornos, de cuerpos y de objetos
+//   cuerpos:   sentencias de cada BlockStatement de función
+//              (los literales de función llevan sus capturas, ver closure_conversion.h)
+//   objetos:   tag + datos; las funciones apuntan a un cuerpo y a un entorno
+//   entornos:  entorno exterior (-1 si no hay) + bindings (nombre, objeto)
+//   id del entorno raíz
+static const char SNAPSHOT_MAGIC[8] = {'C', 'C', 'S', 'N', 'A', 'P', '0', '3'};
+
+enum class ObjectTag : uint8_t { INTEGER, BOOLEAN, NULL_VALUE, FUNCTION, BUILTIN, STRING };
+
+enum class NodeTag : uint8_t {
+    NONE,
+    BLOCK,
+    EXPRESSION_STATEMENT,
+    LET,
+    WHILE,
+    PREFIX,
+    INFIX,
+    IF,
+    CALL,
+    IDENTIFIER,
+    INTEGER,
+    BOOLEAN,
+    FUNCTION,
+    RETURN,
+    BREAK,
+    CONTINUE,
+    FOR,
+    ASSIGN,
+    STRING,
+};
+
+namespace {
+
+class SnapshotWriter {
+public:
+    std::string out;
+
+    bool write_environment_graph(const std::shared_ptr<Environment>& root) {
+        uint32_t root_id = env_id(root.get());
+        // Los ids se asignan mientras se recorre: visitar hasta cerrar el grafo
+        for (size_t i = 0; i < envs.size(); ++i) {
+            const Environment* env = envs[i];
+            if (env->outer_env()) env_id(env->outer_env().get());
+            for (const auto& [name, value] : env->bindings()) {
+                if (!object_id(value)) return false;
+            }
+        }
+
+        out.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        put_u32(static_cast<uint32_t>(envs.size()));
+        put_u32(static_cast<uint32_t>(bodies.size()));
+        put_u32(static_cast<uint32_t>(objects.size()));
+
+        // write_block puede descubrir cuerpos anidados: el vector crece mientras se recorre
+        std::string body_section;
+        body_section.swap(out);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            write_block(bodies[i]);
+        }
+        body_section.swap(out);
+        put_u32(static_cast<uint32_t>(bodies.size()));
+        out += body_section;
+
+        for (const auto& object : objects) {
+            write_object(*object);
+        }
+
+        for (const Environment* env : envs) {
+            put_i32(env->outer_env() ? static_cast<int32_t>(env_id(env->outer_env().get())) : -1);
+            put_u32(static_cast<uint32_t>(env->bindings().size()));
+            for (const auto& [name, value] : env->bindings()) {
+                put_string(name);
+                put_u32(*object_id(value));
+            }
+        }
+        put_u32(root_id);
+        return true;
+    }
+
+private:
+    std::vector<const Environment*> envs;
+    std::unordered_map<const Environment*, uint32_t> env_ids;
+    std::vector<const BlockStatement*> bodies;
+    std::unordered_map<const BlockStatement*, uint32_t> body_ids;
+    std::vector<const Object*> objects;
+    std::unordered_map<const Object*, uint32_t> object_ids;
+
+    void put_u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+    void put_u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+    void put_i32(int32_t v) { put_u32(static_cast<uint32_t>(v)); }
+    void put_string(const std::string& s) {
+        put_u32(static_cast<uint32_t>(s.size()));
+        out += s;
+    }
+    void put_token(const Token& token) {
+        put_u8(static_cast<uint8_t>(token.token_type));
+        put_string(token.literal);
+    }
+
+    uint32_t env_id(const Environment* env) {
+        auto it = env_ids.find(env);
+        if (it != env_ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(envs.size());
+        envs.push_back(env);
+        env_ids.emplace(env, id);
+        return id;
+    }
+
+    uint32_t body_id(const BlockStatement* body) {
+        auto it = body_ids.find(body);
+        if (it != body_ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(bodies.size());
+        bodies.push_back(body);
+        body_ids.emplace(body, id);
+        return id;
+    }
+
+    // Registra el objeto (y lo que alcanza). nullopt si no se puede guardar.
+    std::optional<uint32_t> object_id(const std::shared_ptr<Object>& value) {
+        auto it = object_ids.find(value.get());
+        if (it != object_ids.end()) return it->second;
+
+        switch (value->type()) {
+            case ObjectType::FUNCTION_OBJ: {
+                auto func = static_cast<const Function*>(value.get());
+                // Un cuerpo diferido se guarda ya parseado
+                if (!ensure_parsed(*func->body)) return std::nullopt;
+                body_id(func->body.get());
+                env_id(func->env.get());
+                break;
+            }
+            case ObjectType::INTEGER_OBJ:
+            case ObjectType::BOOLEAN_OBJ:
+            case ObjectType::NULL_OBJ:
+            case ObjectType::BUILTIN_OBJ:
+            case ObjectType::STRING_OBJ:
+                break;
+            default:
+                std::cerr << "Snapshot: no se puede guardar " << value->inspect() << "\n";
+                return std::nullopt;
+        }
+        uint32_t id = static_cast<uint32_t>(objects.size());
+        objects.push_back(value.get());
+        object_ids.emplace(value.get(), id);
+        return id;
+    }
+
+    void write_object(const Object& object) {
+        switch (object.type()) {
+            case ObjectType::INTEGER_OBJ:
+                put_u8(static_cast<uint8_t>(ObjectTag::INTEGER));
+                put_i32(static_cast<const Integer&>(object).value);
+                break;
+            case ObjectType::BOOLEAN_OBJ:
+                put_u8(static_cast<uint8_t>(ObjectTag::BOOLEAN));
+                put_u8(static_cast<const Boolean&>(object).value);
+                break;
+            case ObjectType::FUNCTION_OBJ: {
+                auto& func = static_cast<const Function&>(object);
+                put_u8(static_cast<uint8_t>(ObjectTag::FUNCTION));
+                put_u32(static_cast<uint32_t>(func.parameters.size()));
+                for (const auto& param : func.parameters) put_string(param);
+                put_u32(body_id(func.body.get()));
+                put_u32(env_id(func.env.get()));
+                break;
+            }
+            case ObjectType::BUILTIN_OBJ:
+                put_u8(static_cast<uint8_t>(ObjectTag::BUILTIN));
+                put_string(static_cast<const Builtin&>(object).name);
+                break;
+            case ObjectType::STRING_OBJ:
+                put_u8(static_cast<uint8_t>(ObjectTag::STRING));
+                put_string(std::string(static_cast<const String&>(object).view()));
+                break;
+            default:
+                put_u8(static_cast<uint8_t>(ObjectTag::NULL_VALUE));
+                break;
+        }
+    }
+
+    void write_block(const BlockStatement* block) {
+        put_token(block->token);
+        put_u8(block->frame_escapes);
+        put_u32(static_cast<uint32_t>(block->statements.size()));
+        for (const auto& stmt : block->statements) {
+            write_node(stmt.get());
+        }
+    }
+
+    void write_node(const Node* node) {
+        if (!node) {
+            put_u8(static_cast<uint8_t>(NodeTag::NONE));
+            return;
+        }
+        if (auto block = dynamic_cast<const BlockStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::BLOCK));
+            write_block(block);
+        } else if (auto stmt = dynamic_cast<const ExpressionStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::EXPRESSION_STATEMENT));
+            put_token(stmt->token);
+            write_node(stmt->expression.get());
+        } else if (auto let_stmt = dynamic_cast<const LetStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::LET));
+            put_token(let_stmt->token);
+            put_string(let_stmt->name);
+            write_node(let_stmt->value.get());
+        } else if (auto while_stmt = dynamic_cast<const WhileStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::WHILE));
+            put_token(while_stmt->token);
+            write_node(while_stmt->condition.get());
+            write_node(while_stmt->body.get());
+        } else if (auto for_stmt = dynamic_cast<const ForStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::FOR));
+            put_token(for_stmt->token);
+            write_node(for_stmt->init.get());
+            write_node(for_stmt->condition.get());
+            write_node(for_stmt->update.get());
+            write_node(for_stmt->body.get());
+        } else if (auto assign = dynamic_cast<const AssignExpression*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::ASSIGN));
+            put_token(assign->token);
+            put_string(assign->name);
+            write_node(assign->value.get());
+        } else if (auto return_stmt = dynamic_cast<const ReturnStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::RETURN));
+            put_token(return_stmt->token);
+            write_node(return_stmt->value.get());
+        } else if (auto break_stmt = dynamic_cast<const BreakStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::BREAK));
+            put_token(break_stmt->token);
+        } else if (auto continue_stmt = dynamic_cast<const ContinueStatement*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::CONTINUE));
+            put_token(continue_stmt->token);
+        } else if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::PREFIX));
+            put_token(prefix->token);
+            put_string(prefix->op);
+            write_node(prefix->right.get());
+        } else if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::INFIX));
+            put_token(infix->token);
+            put_string(infix->op);
+            write_node(infix->left.get());
+            write_node(infix->right.get());
+        } else if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::IF));
+            put_token(if_expr->token);
+            write_node(if_expr->condition.get());
+            write_node(if_expr->consequence.get());
+            write_node(if_expr->alternative.get());
+        } else if (auto call = dynamic_cast<const CallExpression*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::CALL));
+            put_token(call->token);
+            write_node(call->function.get());
+            put_u32(static_cast<uint32_t>(call->arguments.size()));
+            for (const auto& arg : call->arguments) write_node(arg.get());
+        } else if (auto ident = dynamic_cast<const Identifier*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::IDENTIFIER));
+            put_token(ident->token);
+            put_string(ident->value);
+        } else if (auto int_lit = dynamic_cast<const IntegerLiteral*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::INTEGER));
+            put_token(int_lit->token);
+            put_i32(int_lit->value);
+        } else if (auto bool_lit = dynamic_cast<const BooleanLiteral*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::BOOLEAN));
+            put_token(bool_lit->token);
+            put_u8(bool_lit->value);
+        } else if (auto str_lit = dynamic_cast<const StringLiteral*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::STRING));
+            put_token(str_lit->token);
+            put_string(std::string(str_lit->value->view()));
+        } else if (auto func = dynamic_cast<const FunctionLiteral*>(node)) {
+            put_u8(static_cast<uint8_t>(NodeTag::FUNCTION));
+            put_token(func->token);
+            put_u32(static_cast<uint32_t>(func->parameters.size()));
+            for (const auto& param : func->parameters) put_string(param);
+            put_u8(func->converted);
+            put_u32(static_cast<uint32_t>(func->captures.size()));
+            for (const auto& name : func->captures) put_string(name);
+            // El cuerpo va por referencia: las clausuras creadas desde este
+            // literal comparten el mismo BlockStatement
+            put_u32(body_id(func->body.get()));
+        } else {
+            put_u8(static_cast<uint8_t>(NodeTag::NONE));
+        }
+    }
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    std::shared_ptr<Environment> read() {
+        if (static_cast<size_t>(end - cursor) < sizeof(SNAPSHOT_MAGIC) ||
+            std::memcmp(cursor, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            return nullptr;
+        }
+        cursor += sizeof(SNAPSHOT_MAGIC);
+
+        uint32_t env_count = get_count();
+        get_u32();   // cuerpos registrados antes de recorrer el AST
+        uint32_t object_count = get_count();
+        uint32_t body_count = get_count();
+        if (failed || env_count == 0) return nullptr;
+
+        // Primero se crean vacíos: funciones y entornos se referencian en ciclo
+        for (uint32_t i = 0; i < env_count; ++i) envs.push_back(make_pooled<Environment>());
+        for (uint32_t i = 0; i < body_count; ++i) {
+            bodies.push_back(std::make_shared<BlockStatement>(Token(TokenType::LBRACE, "{")));
+        }
+
+        for (uint32_t i = 0; i < body_count && !failed; ++i) {
+            read_block_into(*bodies[i]);
+        }
+        for (uint32_t i = 0; i < object_count && !failed; ++i) {
+            objects.push_back(read_object());
+        }
+        for (uint32_t i = 0; i < env_count && !failed; ++i) {
+            int32_t outer = get_i32();
+            if (outer >= 0) {
+                if (static_cast<uint32_t>(outer) >= envs.size()) return nullptr;
+                envs[i]->reset(envs[outer]);
+            }
+            uint32_t binding_count = get_count();
+            for (uint32_t j = 0; j < binding_count && !failed; ++j) {
+                std::string name = get_string();
+                uint32_t id = get_u32();
+                if (id >= objects.size()) return nullptr;
+                envs[i]->set(name, objects[id]);
+            }
+        }
+        uint32_t root = get_u32();
+        if (failed || root >= envs.size()) return nullptr;
+        return envs[root];
+    }
+
+private:
+    const char* cursor;
+    const char* end;
+    bool failed = false;
+    std::vector<std::shared_ptr<Environment>> envs;
+    std::vector<std::shared_ptr<BlockStatement>> bodies;
+    std::vector<std::shared_ptr<Object>> objects;
+
+    bool need(size_t n) {
+        if (failed || static_cast<size_t>(end - cursor) < n) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+    uint8_t get_u8() {
+        if (!need(1)) return 0;
+        return static_cast<uint8_t>(*cursor++);
+    }
+    uint32_t get_u32() {
+        if (!need(4)) return 0;
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(cursor[i])) << (8 * i);
+        cursor += 4;
+        return v;
+    }
+    int32_t get_i32() { return static_cast<int32_t>(get_u32()); }
+    // Cantidad de elementos que siguen: cada uno ocupa al menos un byte, así
+    // que una mayor que lo que queda es un archivo truncado o corrupto y no
+    // debe llegar a reservar memoria
+    uint32_t get_count() {
+        uint32_t count = get_u32();
+        if (!need(count)) return 0;
+        return count;
+    }
+    std::string get_string() {
+        uint32_t size = get_u32();
+        if (!need(size)) return "";
+        std::string s(cursor, size);
+        cursor += size;
+        return s;
+    }
+    Token get_token() {
+        auto type = static_cast<TokenType>(get_u8());
+        return Token(type, get_string());
+    }
+
+    std::shared_ptr<BlockStatement> body_ref() {
+        uint32_t id = get_u32();
+        if (id >= bodies.size()) {
+            failed = true;
+            return std::make_shared<BlockStatement>(Token(TokenType::LBRACE, "{"));
+        }
+        return bodies[id];
+    }
+
+    std::shared_ptr<Environment> env_ref() {
+        uint32_t id = get_u32();
+        if (id >= envs.size()) {
+            failed = true;
+            return nullptr;
+        }
+        return envs[id];
+    }
+
+    std::shared_ptr<Object> read_object() {
+        switch (static_cast<ObjectTag>(get_u8())) {
+            case ObjectTag::INTEGER:
+                return std::make_shared<Integer>(get_i32());
+            case ObjectTag::BOOLEAN:
+                return std::make_shared<Boolean>(get_u8() != 0);
+            case ObjectTag::FUNCTION: {
+                std::vector<std::string> params(get_count());
+                for (auto& param : params) param = get_string();
+                auto body = body_ref();
+                auto env = env_ref();
+                return make_pooled<Function>(std::move(params), std::move(body), std::move(env));
+            }
+            case ObjectTag::BUILTIN: {
+                auto builtin = lookup_builtin(get_string());
+                if (!builtin) failed = true;
+                return builtin;
+            }
+            case ObjectTag::STRING:
+                return make_string(get_string());
+            case ObjectTag::NULL_VALUE:
+                return std::make_shared<Null>();
+        }
+        failed = true;
+        return nullptr;
+    }
+
+    void read_block_into(BlockStatement& block) {
+        block.token = get_token();
+        block.frame_escapes = get_u8() != 0;
+        uint32_t count = get_count();
+        for (uint32_t i = 0; i < count && !failed; ++i) {
+            auto node = read_node();
+            auto stmt = dynamic_cast<Statement*>(node.get());
+            if (!stmt) {
+                failed = true;
+                return;
+            }
+            node.release();
+            block.statements.emplace_back(stmt);
+        }
+    }
+
+    template <typename T>
+    std::unique_ptr<T> read_as() {
+        auto node = read_node();
+        if (!node) return nullptr;
+        auto typed = dynamic_cast<T*>(node.get());
+        if (!typed) {
+            failed = true;
+            return nullptr;
+        }
+        node.release();
+        return std::unique_ptr<T>(typed);
+    }
+
+    std::unique_ptr<Node> read_node() {
+        if (failed) return nullptr;
+        switch (static_cast<NodeTag>(get_u8())) {
+            case NodeTag::NONE:
+                return nullptr;
+            case NodeTag::BLOCK: {
+                auto block = std::make_unique<BlockStatement>(Token());
+                read_block_into(*block);
+                return block;
+            }
+            case NodeTag::EXPRESSION_STATEMENT: {
+                Token token = get_token();
+                return std::make_unique<ExpressionStatement>(token, read_as<Expression>());
+            }
+            case NodeTag::LET: {
+                Token token = get_token();
+                std::string name = get_string();
+                return std::make_unique<LetStatement>(token, name, read_as<Expression>());
+            }
+            case NodeTag::WHILE: {
+                Token token = get_token();
+                auto condition = read_as<Expression>();
+                auto body = read_as<BlockStatement>();
+                return std::make_unique<WhileStatement>(token, std::move(condition), std::move(body));
+            }
+            case NodeTag::FOR: {
+                auto loop = std::make_unique<ForStatement>(get_token());
+                loop->init = read_as<Statement>();
+                loop->condition = read_as<Expression>();
+                loop->update = read_as<Statement>();
+                loop->body = read_as<BlockStatement>();
+                loop->counted = analyze_counted_loop(loop.get());
+                return loop;
+            }
+            case NodeTag::ASSIGN: {
+                Token token = get_token();
+                std::string name = get_string();
+                return std::make_unique<AssignExpression>(token, name, read_as<Expression>());
+            }
+            case NodeTag::RETURN: {
+                Token token = get_token();
+                return std::make_unique<ReturnStatement>(token, read_as<Expression>());
+            }
+            case NodeTag::BREAK:
+                return std::make_unique<BreakStatement>(get_token());
+            case NodeTag::CONTINUE:
+                return std::make_unique<ContinueStatement>(get_token());
+            case NodeTag::PREFIX: {
+                Token token = get_token();
+                std::string op = get_string();
+                return std::make_unique<PrefixExpression>(token, op, read_as<Expression>());
+            }
+            case NodeTag::INFIX: {
+                Token token = get_token();
+                std::string op = get_string();
+                auto left = read_as<Expression>();
+                auto right = read_as<Expression>();
+                return std::make_unique<InfixExpression>(token, std::move(left), op, std::move(right));
+            }
+            case NodeTag::IF: {
+                auto if_expr = std::make_unique<IfExpression>(get_token());
+                if_expr->condition = read_as<Expression>();
+                if_expr->consequence = read_as<BlockStatement>();
+                if_expr->alternative = read_as<BlockStatement>();
+                return if_expr;
+            }
+            case NodeTag::CALL: {
+                Token token = get_token();
+                auto call = std::make_unique<CallExpression>(token, read_as<Expression>());
+                uint32_t count = get_count();
+                for (uint32_t i = 0; i < count && !failed; ++i) {
+                    call->arguments.push_back(read_as<Expression>());
+                }
+                return call;
+            }
+            case NodeTag::IDENTIFIER: {
+                Token token = get_token();
+                return std::make_unique<Identifier>(token, get_string());
+            }
+            case NodeTag::INTEGER: {
+                Token token = get_token();
+                return std::make_unique<IntegerLiteral>(token, get_i32());
+            }
+            case NodeTag::BOOLEAN: {
+                Token token = get_token();
+                return std::make_unique<BooleanLiteral>(token, get_u8() != 0);
+            }
+            case NodeTag::STRING: {
+                Token token = get_token();
+                return std::make_unique<StringLiteral>(token, make_string(get_string()));
+            }
+            case NodeTag::FUNCTION: {
+                auto func = std::make_unique<FunctionLiteral>(get_token());
+                func->parameters.resize(get_count());
+                for (auto& param : func->parameters) param = get_string();
+                func->converted = get_u8() != 0;
+                func->captures.resize(get_count());
+                for (auto& name : func->captures) name = get_string();
+                func->body = body_ref();
+                return func;
+            }
+        }
+        failed = true;
+        return nullptr;
+    }
+};
+
+} // namespace
+
+bool save_snapshot(const std::shared_ptr<Environment>& env, const std::string& path) {
+    SnapshotWriter writer;
+    if (!writer.write_environment_graph(env)) {
+        return false;
+    }
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.write(writer.out.data(), static_cast<std::streamsize>(writer.out.size()))) {
+        std::cerr << "No se pudo escribir " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<Environment> load_snapshot(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "No se pudo abrir " << path << "\n";
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+        close(fd);
+        std::cerr << "Snapshot inválido: " << path << "\n";
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "No se pudo mapear " << path << "\n";
+        return nullptr;
+    }
+
+    SnapshotReader reader(static_cast<const char*>(data), size);
+    auto env = reader.read();
+    munmap(data, size);
+
+    if (!env) {
+        std::cerr << "Snapshot inválido: " << path << "\n";
+    }
+    return env;
+}
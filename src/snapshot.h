@@ -0,0 +1,18 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <memory>
+#include <string>
+#include "environment.h"
+
+// Snapshot binario de un entorno ya evaluado: sus bindings, los entornos
+// exteriores y todo lo alcanzable desde ellos (valores, funciones con sus
+// clausuras y el AST de sus cuerpos). Cargarlo no vuelve a lexear, parsear
+// ni evaluar el preludio: el archivo se mapea en memoria y se reconstruye el
+// grafo de objetos directamente.
+bool save_snapshot(const std::shared_ptr<Environment>& env, const std::string& path);
+
+// Devuelve nullptr (con el error reportado) si el archivo no es un snapshot válido
+std::shared_ptr<Environment> load_snapshot(const std::string& path);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,556 @@
+#include "stackless_evaluator.h"
+#include "evaluator.h"
+#include "call_frames.h"
+#include "closure_conversion.h"
+#include "loop_tier.h"
+#include "builtins.h"
+#include "parser.h"
+#include "value_numbering.h"
+#include "inlining.h"
+#include "string_object.h"
+#include <algorithm>
+#include <iostream>
+
+StacklessEvaluator::StacklessEvaluator(size_t max_frames) : max_frames(std::max<size_t>(max_frames, 1)) {}
+
+StacklessEvaluator::NodeKind StacklessEvaluator::classify(Node* node) {
+    if (dynamic_cast<Program*>(node)) return NodeKind::PROGRAM;
+    if (dynamic_cast<BlockStatement*>(node)) return NodeKind::BLOCK;
+    if (dynamic_cast<ExpressionStatement*>(node)) return NodeKind::EXPRESSION_STATEMENT;
+    if (dynamic_cast<LetStatement*>(node)) return NodeKind::LET;
+    if (dynamic_cast<AssignExpression*>(node)) return NodeKind::ASSIGN;
+    if (dynamic_cast<WhileStatement*>(node)) return NodeKind::WHILE;
+    if (dynamic_cast<ForStatement*>(node)) return NodeKind::FOR;
+    if (dynamic_cast<PrefixExpression*>(node)) return NodeKind::PREFIX;
+    if (dynamic_cast<InfixExpression*>(node)) return NodeKind::INFIX;
+    if (dynamic_cast<IfExpression*>(node)) return NodeKind::IF;
+    if (dynamic_cast<CallExpression*>(node)) return NodeKind::CALL;
+    if (dynamic_cast<Identifier*>(node)) return NodeKind::IDENTIFIER;
+    if (dynamic_cast<FunctionLiteral*>(node)) return NodeKind::FUNCTION;
+    if (dynamic_cast<ReturnStatement*>(node)) return NodeKind::RETURN;
+    if (dynamic_cast<BreakStatement*>(node)) return NodeKind::BREAK;
+    if (dynamic_cast<ContinueStatement*>(node)) return NodeKind::CONTINUE;
+    return NodeKind::UNKNOWN;
+}
+
+bool StacklessEvaluator::immediate_value(Node* node, std::shared_ptr<Object>& value) {
+    if (!node) {
+        value = nullptr;
+        return true;
+    }
+    if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+        value = std::make_shared<Integer>(int_lit->value);
+        return true;
+    }
+    if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
+        value = std::make_shared<Boolean>(bool_lit->value);
+        return true;
+    }
+    if (auto str_lit = dynamic_cast<StringLiteral*>(node)) {
+        value = str_lit->value;
+        return true;
+    }
+    return reuse_numbered_value(node, value);
+}
+
+// Agrega la evaluación de node. Devuelve OVERFLOW si se superó el límite de marcos.
+StacklessEvaluator::StepResult StacklessEvaluator::push(Node* node, std::shared_ptr<Environment> env) {
+    std::shared_ptr<Object> value;
+    if (immediate_value(node, value)) {
+        values.push_back(std::move(value));
+        return StepResult::CONTINUE;
+    }
+    if (frames.size() >= max_frames) {
+        return StepResult::OVERFLOW;
+    }
+    Frame& frame = frames.emplace_back();
+    frame.node = node;
+    frame.kind = classify(node);
+    frame.env = std::move(env);
+    frame.values_base = values.size();
+    return StepResult::CONTINUE;
+}
+
+// Continuación en posición de cola: el marco actual pasa a evaluar node,
+// cuyo resultado será directamente el resultado del marco.
+void StacklessEvaluator::replace(Node* node, std::shared_ptr<Environment> env) {
+    std::shared_ptr<Object> value;
+    if (immediate_value(node, value)) {
+        finish(std::move(value));
+        return;
+    }
+    Frame& frame = frames.back();
+    frame.node = node;
+    frame.kind = classify(node);
+    frame.stage = 0;
+    frame.index = 0;
+    frame.env = std::move(env);
+    frame.value = nullptr;
+    frame.counted = nullptr;
+}
+
+void StacklessEvaluator::finish(std::shared_ptr<Object> value) {
+    frames.pop_back();
+    values.push_back(std::move(value));
+}
+
+std::shared_ptr<Object> StacklessEvaluator::pop_value() {
+    auto value = std::move(values.back());
+    values.pop_back();
+    return value;
+}
+
+// Descarta la continuación del tope, devolviendo su marco de llamada a la FrameStack
+void StacklessEvaluator::pop_frame() {
+    Frame& frame = frames.back();
+    if (frame.frame_on_stack) {
+        frame.call_env.reset();
+        frame_stack.pop();
+    }
+    frames.pop_back();
+}
+
+// Descarta todas las continuaciones
+void StacklessEvaluator::unwind() {
+    while (!frames.empty()) {
+        pop_frame();
+    }
+    values.clear();
+}
+
+// return/break/continue: descarta las continuaciones hasta la llamada (o el
+// ciclo) que los recibe, junto con los valores parciales que habían dejado
+// en la pila de valores.
+void StacklessEvaluator::propagate(Flow flow, std::shared_ptr<Object> value) {
+    size_t base = values.size();
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        bool body_done = frame.stage == 2;
+        bool is_loop = frame.kind == NodeKind::WHILE || frame.kind == NodeKind::FOR;
+        if (is_loop && body_done && flow != Flow::RETURN) {
+            values.resize(base);
+            if (flow == Flow::BREAK) {
+                finish(std::move(frame.value));
+            } else {
+                frame.stage = 3;   // vuelta terminada sin resultado nuevo
+            }
+            return;
+        }
+        if ((frame.kind == NodeKind::CALL && body_done) || frame.kind == NodeKind::PROGRAM) {
+            if (flow != Flow::RETURN) {
+                report_stray_flow(flow);
+                value = nullptr;
+            }
+            if (frame.kind == NodeKind::PROGRAM) {
+                frame.index = static_cast<Program*>(frame.node)->statements.size();
+            }
+            values.resize(base);
+            values.push_back(std::move(value));
+            return;
+        }
+        base = frame.values_base;
+        pop_frame();
+    }
+
+    // Sin marco que lo reciba: era una sentencia suelta de nivel superior
+    values.resize(base);
+    if (flow == Flow::RETURN) {
+        final_flow = Flow::RETURN;
+    } else {
+        report_stray_flow(flow);
+        value = nullptr;
+    }
+    values.push_back(std::move(value));
+}
+
+void StacklessEvaluator::start(Node* node, std::shared_ptr<Environment> env) {
+    unwind();
+    final_value = nullptr;
+    final_flow = Flow::NORMAL;
+    pending = nullptr;
+    pending_arguments.clear();
+    push(node, std::move(env));
+}
+
+StacklessEvaluator::Status StacklessEvaluator::run() {
+    while (!frames.empty()) {
+        StepResult step_result = step();
+        if (step_result == StepResult::SUSPEND) {
+            return Status::SUSPENDED;
+        }
+        if (step_result == StepResult::OVERFLOW) {
+            unwind();
+            std::cerr << "Desbordamiento de pila (stack overflow): límite de " << max_frames << " marcos\n";
+            return Status::FAILED;
+        }
+    }
+    final_value = pop_value();
+    return Status::DONE;
+}
+
+// Entrega el resultado del builtin pendiente: es el valor de la llamada
+void StacklessEvaluator::resume(std::shared_ptr<Object> value) {
+    pending = nullptr;
+    pending_arguments.clear();
+    finish(std::move(value));
+}
+
+std::shared_ptr<Object> StacklessEvaluator::eval(Node* node, std::shared_ptr<Environment> env) {
+    start(node, std::move(env));
+    while (true) {
+        switch (run()) {
+            case Status::DONE:
+                return result();
+            case Status::FAILED:
+                return nullptr;
+            case Status::SUSPENDED:
+                resume(call_builtin_blocking(pending_builtin(), pending_args()));
+                break;
+        }
+    }
+}
+
+// Avanza una etapa de la continuación del tope. Devuelve OVERFLOW si no hubo
+// lugar para una continuación nueva y SUSPEND al llegar a un builtin.
+StacklessEvaluator::StepResult StacklessEvaluator::step() {
+    Frame& frame = frames.back();
+    AllocSiteScope site(frame.node);
+
+    switch (frame.kind) {
+        case NodeKind::PROGRAM: {
+            auto program = static_cast<Program*>(frame.node);
+            if (frame.index > 0) {
+                frame.value = pop_value();
+            }
+            if (frame.index == program->statements.size()) {
+                finish(std::move(frame.value));
+                return StepResult::CONTINUE;
+            }
+            Statement* stmt = program->statements[frame.index++].get();
+            return push(stmt, frame.env);
+        }
+
+        case NodeKind::BLOCK: {
+            auto block = static_cast<BlockStatement*>(frame.node);
+            if (frame.index > 0) {
+                pop_value();
+            }
+            if (block->statements.empty()) {
+                finish(nullptr);
+                return StepResult::CONTINUE;
+            }
+            Statement* stmt = block->statements[frame.index++].get();
+            if (frame.index == block->statements.size()) {
+                // La última sentencia da el resultado del bloque
+                replace(stmt, frame.env);
+                return StepResult::CONTINUE;
+            }
+            return push(stmt, frame.env);
+        }
+
+        case NodeKind::EXPRESSION_STATEMENT: {
+            auto stmt = static_cast<ExpressionStatement*>(frame.node);
+            replace(stmt->expression.get(), frame.env);
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::IDENTIFIER: {
+            finish(eval_identifier(static_cast<Identifier*>(frame.node), frame.env));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::LET: {
+            auto let_stmt = static_cast<LetStatement*>(frame.node);
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(let_stmt->value.get(), frame.env);
+            }
+            finish(bind_let(let_stmt, pop_value(), frame.env));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::ASSIGN: {
+            auto assign = static_cast<AssignExpression*>(frame.node);
+            if (frame.stage == 0) {
+                if (auto updated = assign_in_place(assign, frame.env)) {
+                    finish(std::move(updated));
+                    return StepResult::CONTINUE;
+                }
+                frame.stage = 1;
+                return push(assign->value.get(), frame.env);
+            }
+            finish(assign_binding(assign, pop_value(), frame.env));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::RETURN: {
+            auto return_stmt = static_cast<ReturnStatement*>(frame.node);
+            if (!return_stmt->value) {
+                propagate(Flow::RETURN, std::make_shared<Null>());
+                return StepResult::CONTINUE;
+            }
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(return_stmt->value.get(), frame.env);
+            }
+            propagate(Flow::RETURN, pop_value());
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::BREAK:
+            propagate(Flow::BREAK, nullptr);
+            return StepResult::CONTINUE;
+
+        case NodeKind::CONTINUE:
+            propagate(Flow::CONTINUE, nullptr);
+            return StepResult::CONTINUE;
+
+        case NodeKind::PREFIX: {
+            auto prefix = static_cast<PrefixExpression*>(frame.node);
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(prefix->right.get(), frame.env);
+            }
+            finish(define_numbered_value(prefix, eval_prefix_expression(prefix, pop_value())));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::INFIX: {
+            auto infix = static_cast<InfixExpression*>(frame.node);
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(infix->left.get(), frame.env);
+            }
+            if (frame.stage == 1) {
+                frame.stage = 2;
+                return push(infix->right.get(), frame.env);
+            }
+            auto right = pop_value();
+            auto left = pop_value();
+            finish(define_numbered_value(infix, eval_infix_expression(infix, left, right)));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::IF: {
+            auto if_expr = static_cast<IfExpression*>(frame.node);
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(if_expr->condition.get(), frame.env);
+            }
+            auto condition = pop_value();
+            if (!condition) {
+                finish(nullptr);
+            } else if (is_truthy(if_expr->condition.get(), condition)) {
+                replace(if_expr->consequence.get(), frame.env);
+            } else if (if_expr->alternative) {
+                replace(if_expr->alternative.get(), frame.env);
+            } else {
+                finish(std::make_shared<Null>());
+            }
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::WHILE: {
+            auto while_stmt = static_cast<WhileStatement*>(frame.node);
+            // etapa 0: evaluar condición, 1: condición lista, 2: cuerpo listo,
+            // 3: cuerpo cortado por un continue
+            if (frame.stage == 2 || frame.stage == 3) {
+                if (frame.stage == 2) frame.value = pop_value();
+                if (++frame.index == LOOP_TIER_THRESHOLD && run_loop_tier(while_stmt, frame.env, frame.value)) {
+                    finish(std::move(frame.value));
+                    return StepResult::CONTINUE;
+                }
+                frame.stage = 0;
+            }
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(while_stmt->condition.get(), frame.env);
+            }
+            if (!loop_continues(while_stmt->condition.get(), pop_value())) {
+                finish(std::move(frame.value));
+                return StepResult::CONTINUE;
+            }
+            frame.stage = 2;
+            return push(while_stmt->body.get(), frame.env);
+        }
+
+        case NodeKind::FOR: {
+            auto loop = static_cast<ForStatement*>(frame.node);
+            // etapa 0: init, 1: init listo, 2: cuerpo listo, 3: cuerpo cortado
+            // por un continue, 4: probar la condición, 5: actualización lista,
+            // 6: condición lista.
+            bool counted = frame.counted != nullptr;
+            switch (frame.stage) {
+                case 0:
+                    frame.stage = 1;
+                    if (loop->init) return push(loop->init.get(), frame.env);
+                    values.push_back(nullptr);
+                    return StepResult::CONTINUE;
+                case 1:
+                    pop_value();
+                    if (loop->counted.valid) {
+                        frame.counted = std::make_unique<ForLoopState>();
+                        if (!for_loop_start(loop, frame.env, *frame.counted)) frame.counted = nullptr;
+                    }
+                    frame.stage = 4;
+                    return StepResult::CONTINUE;
+                case 2:
+                case 3:
+                    if (frame.stage == 2) frame.value = pop_value();
+                    if (counted) {
+                        for_loop_advance(loop, *frame.counted);
+                    } else if (loop->update) {
+                        frame.stage = 5;
+                        return push(loop->update.get(), frame.env);
+                    }
+                    [[fallthrough]];
+                case 5:
+                    if (frame.stage == 5) pop_value();
+                    if (++frame.index == LOOP_TIER_THRESHOLD && run_loop_tier(loop, frame.env, frame.value)) {
+                        finish(std::move(frame.value));
+                        return StepResult::CONTINUE;
+                    }
+                    frame.stage = 4;
+                    return StepResult::CONTINUE;
+                case 4:
+                    if (!counted && loop->condition) {
+                        frame.stage = 6;
+                        return push(loop->condition.get(), frame.env);
+                    }
+                    if (counted && !for_loop_continues(loop, *frame.counted)) {
+                        finish(std::move(frame.value));
+                        return StepResult::CONTINUE;
+                    }
+                    frame.stage = 2;
+                    return push(loop->body.get(), frame.env);
+                default:
+                    if (!loop_continues(loop->condition.get(), pop_value())) {
+                        finish(std::move(frame.value));
+                        return StepResult::CONTINUE;
+                    }
+                    frame.stage = 2;
+                    return push(loop->body.get(), frame.env);
+            }
+        }
+
+        case NodeKind::FUNCTION: {
+            auto func = static_cast<FunctionLiteral*>(frame.node);
+            finish(make_closure(func, frame.env));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::CALL: {
+            auto call = static_cast<CallExpression*>(frame.node);
+            // etapa 0: evaluar la función, 1: crear el marco y evaluar
+            // argumentos, 2: cuerpo evaluado, 3: argumentos de un builtin,
+            // 4: argumentos de una llamada en línea
+            if (frame.stage == 0) {
+                frame.stage = 1;
+                return push(call->function.get(), frame.env);
+            }
+
+            if (frame.stage == 4) {
+                // Como al ligarlos en el marco, se corta en el primero que falla
+                if (frame.index > 0 && !values.back()) {
+                    values.resize(values.size() - frame.index);
+                    finish(nullptr);
+                    return StepResult::CONTINUE;
+                }
+                if (frame.index < call->arguments.size()) {
+                    Expression* arg = call->arguments[frame.index++].get();
+                    return push(arg, frame.env);
+                }
+                size_t first = values.size() - call->arguments.size();
+                auto result = eval_inlined_call(static_cast<InlinedCall&>(*call),
+                                                static_cast<Function&>(*frame.value), values.data() + first);
+                values.resize(first);
+                finish(std::move(result));
+                return StepResult::CONTINUE;
+            }
+
+            if (frame.stage == 3) {
+                // Argumentos de un builtin: se acumulan en la pila de valores
+                if (frame.index < call->arguments.size()) {
+                    Expression* arg = call->arguments[frame.index++].get();
+                    return push(arg, frame.env);
+                }
+                size_t first = values.size() - call->arguments.size();
+                for (size_t i = first; i < values.size(); ++i) {
+                    if (!values[i]) {
+                        values.resize(first);
+                        finish(nullptr);
+                        return StepResult::CONTINUE;
+                    }
+                }
+                pending = std::static_pointer_cast<Builtin>(frame.value);
+                pending_arguments.assign(std::make_move_iterator(values.begin() + first),
+                                         std::make_move_iterator(values.end()));
+                values.resize(first);
+                return StepResult::SUSPEND;
+            }
+
+            if (frame.stage == 1) {
+                if (frame.index == 0) {
+                    auto callee = pop_value();
+                    auto inlined = dynamic_cast<InlinedCall*>(call);
+                    if (inlined && inline_target(*inlined, callee)) {
+                        frame.value = std::move(callee);
+                        frame.stage = 4;
+                        return StepResult::CONTINUE;
+                    }
+                    if (callee && callee->type() == ObjectType::BUILTIN_OBJ) {
+                        if (!check_builtin_arity(static_cast<Builtin&>(*callee), call->arguments.size())) {
+                            finish(nullptr);
+                            return StepResult::CONTINUE;
+                        }
+                        frame.value = callee;
+                        frame.stage = 3;
+                        return StepResult::CONTINUE;
+                    }
+                    auto func = check_callable(callee, call->arguments.size());
+                    if (!func || !ensure_parsed(*func->body)) {
+                        finish(nullptr);
+                        return StepResult::CONTINUE;
+                    }
+                    frame.frame_on_stack = !func->body->frame_escapes;
+                    if (frame.frame_on_stack) {
+                        frame.call_env = std::shared_ptr<Environment>(std::shared_ptr<Environment>(),
+                                                                      frame_stack.push(func->env));
+                    } else {
+                        frame.call_env = make_pooled<Environment>(func->env);
+                    }
+                    frame.value = func;
+                } else {
+                    auto arg_val = pop_value();
+                    auto func = std::static_pointer_cast<Function>(frame.value);
+                    if (!arg_val) {
+                        frame.call_env.reset();
+                        if (frame.frame_on_stack) frame_stack.pop();
+                        finish(nullptr);
+                        return StepResult::CONTINUE;
+                    }
+                    frame.call_env->set(func->parameters[frame.index - 1], arg_val);
+                }
+
+                auto func = std::static_pointer_cast<Function>(frame.value);
+                if (frame.index < call->arguments.size()) {
+                    Expression* arg = call->arguments[frame.index++].get();
+                    return push(arg, frame.env);
+                }
+                frame.stage = 2;
+                return push(func->body.get(), frame.call_env);
+            }
+
+            auto result = pop_value();
+            frame.call_env.reset();
+            if (frame.frame_on_stack) frame_stack.pop();
+            finish(std::move(result));
+            return StepResult::CONTINUE;
+        }
+
+        case NodeKind::UNKNOWN:
+            finish(nullptr);
+            return StepResult::CONTINUE;
+    }
+    return StepResult::CONTINUE;
+}
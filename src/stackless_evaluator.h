@@ -0,0 +1,113 @@
+#ifndef STACKLESS_EVALUATOR_H
+#define STACKLESS_EVALUATOR_H
+
+#include <memory>
+#include <vector>
+#include "ast.h"
+#include "object.h"
+#include "environment.h"
+#include "call_frames.h"
+#include "evaluator.h"
+
+// Evaluador que no usa la pila nativa: las continuaciones viven en un
+// vector que crece en el heap, así que la profundidad de recursión de los
+// scripts no depende del tamaño de pila del hilo. Al superar max_frames la
+// evaluación se corta con un error de desbordamiento de pila.
+// Tiene la misma semántica que eval() en evaluator.h.
+//
+// Como todo su estado está en el heap, la evaluación se puede suspender en
+// una llamada a un builtin y retomar después (ver event_loop.h):
+//
+//     evaluator.start(program, env);
+//     while (evaluator.run() == StacklessEvaluator::Status::SUSPENDED) {
+//         ... resolver evaluator.pending_builtin() con pending_args() ...
+//         evaluator.resume(valor);
+//     }
+class StacklessEvaluator {
+public:
+    static constexpr size_t DEFAULT_MAX_FRAMES = 10'000'000;
+
+    enum class Status {
+        DONE,        // result() tiene el valor final
+        SUSPENDED,   // esperando el resultado de pending_builtin()
+        FAILED,      // desbordamiento de pila (ya reportado)
+    };
+
+    explicit StacklessEvaluator(size_t max_frames = DEFAULT_MAX_FRAMES);
+
+    // Evalúa hasta el final; los builtins se resuelven en el hilo actual
+    std::shared_ptr<Object> eval(Node* node, std::shared_ptr<Environment> env);
+
+    void start(Node* node, std::shared_ptr<Environment> env);
+    Status run();
+    void resume(std::shared_ptr<Object> value);
+    std::shared_ptr<Object> result() const { return final_value; }
+    // RETURN si la evaluación terminó con un return fuera de toda función
+    Flow flow() const { return final_flow; }
+
+    const Builtin& pending_builtin() const { return *pending; }
+    std::vector<std::shared_ptr<Object>>& pending_args() { return pending_arguments; }
+
+private:
+    enum class NodeKind {
+        PROGRAM,
+        BLOCK,
+        EXPRESSION_STATEMENT,
+        LET,
+        ASSIGN,
+        WHILE,
+        FOR,
+        PREFIX,
+        INFIX,
+        IF,
+        CALL,
+        IDENTIFIER,
+        FUNCTION,
+        RETURN,
+        BREAK,
+        CONTINUE,
+        UNKNOWN,
+    };
+
+    // Continuación pendiente: qué nodo se está evaluando y en qué etapa va
+    struct Frame {
+        Node* node;
+        NodeKind kind;
+        int stage = 0;
+        size_t index = 0;
+        std::shared_ptr<Environment> env;
+        std::shared_ptr<Environment> call_env;   // marco de la función llamada
+        std::shared_ptr<Object> value;           // resultado parcial / función llamada
+        bool frame_on_stack = false;             // call_env está en la FrameStack
+        size_t values_base = 0;                  // tamaño de values al crear el marco
+        std::unique_ptr<ForLoopState> counted;   // solo en un for contado
+    };
+
+    enum class StepResult { CONTINUE, OVERFLOW, SUSPEND };
+
+    size_t max_frames;
+    std::vector<Frame> frames;
+    std::vector<std::shared_ptr<Object>> values;
+    // Propia de cada evaluador: varias evaluaciones suspendidas pueden
+    // intercalarse en el mismo hilo sin romper el orden LIFO de los marcos
+    FrameStack frame_stack;
+    std::shared_ptr<Object> final_value;
+    Flow final_flow = Flow::NORMAL;
+    std::shared_ptr<Builtin> pending;
+    std::vector<std::shared_ptr<Object>> pending_arguments;
+
+    StepResult push(Node* node, std::shared_ptr<Environment> env);
+    void replace(Node* node, std::shared_ptr<Environment> env);
+    void finish(std::shared_ptr<Object> value);
+    std::shared_ptr<Object> pop_value();
+    StepResult step();
+    void unwind();
+    void pop_frame();
+    void propagate(Flow flow, std::shared_ptr<Object> value);
+
+    static NodeKind classify(Node* node);
+    // Literales que se resuelven sin crear una continuación
+    static bool immediate_value(Node* node, std::shared_ptr<Object>& value);
+};
+
+#endif // STACKLESS_EVALUATOR_H
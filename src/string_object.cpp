@@ -0,0 +1,157 @@
+#include "string_object.h"
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct InternTable {
+    std::mutex mutex;
+    // Las claves apuntan al texto de su propio InternedText
+    std::unordered_map<std::string_view, std::weak_ptr<const InternedText>> entries;
+};
+
+// Nunca se destruye: puede haber cadenas vivas (en un thread_local, por
+// ejemplo) que la usen al terminar el programa
+InternTable& intern_table() {
+    static InternTable* table = new InternTable();
+    return *table;
+}
+
+void release_interned(const InternedText* dying) {
+    InternTable& table = intern_table();
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        auto it = table.entries.find(dying->text);
+        // Si ya la reemplazó otra con el mismo texto, la entrada es de esa
+        if (it != table.entries.end() && it->first.data() == dying->text.data()) {
+            table.entries.erase(it);
+        }
+    }
+    delete dying;
+}
+
+} // namespace
+
+std::shared_ptr<const InternedText> intern_text(std::string text) {
+    InternTable& table = intern_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.entries.find(text);
+    if (it != table.entries.end()) {
+        if (auto existing = it->second.lock()) return existing;
+        // La última cadena que la usaba se está liberando en otro hilo
+        table.entries.erase(it);
+    }
+    auto raw = new InternedText{std::move(text)};
+    std::shared_ptr<const InternedText> interned(raw, release_interned);
+    table.entries.emplace(raw->text, interned);
+    return interned;
+}
+
+String::String(std::string_view text) : length(text.size()) {
+    profile_allocation(this, typeid(String), sizeof(String));
+    if (length <= SMALL_STRING) {
+        kind = Kind::SMALL;
+        std::memcpy(small, text.data(), length);
+    } else {
+        kind = Kind::INTERNED;
+        this->text = intern_text(std::string(text));
+    }
+}
+
+String::String(std::shared_ptr<String> left, std::shared_ptr<String> right)
+    : kind(Kind::ROPE), length(left->size() + right->size()), left(std::move(left)), right(std::move(right)) {
+    profile_allocation(this, typeid(String), sizeof(String));
+}
+
+String::~String() {
+    if (kind != Kind::ROPE) return;
+    // Una rope hecha con s = s + x en un ciclo tiene un nivel por vuelta:
+    // liberarla recursivamente podría agotar la pila
+    std::vector<std::shared_ptr<String>> pending;
+    pending.push_back(left.exchange(nullptr));
+    pending.push_back(right.exchange(nullptr));
+    while (!pending.empty()) {
+        std::shared_ptr<String> node = std::move(pending.back());
+        pending.pop_back();
+        if (node && node.use_count() == 1 && node->kind == Kind::ROPE) {
+            pending.push_back(node->left.exchange(nullptr));
+            pending.push_back(node->right.exchange(nullptr));
+        }
+    }
+}
+
+std::string_view String::view() const {
+    if (kind == Kind::SMALL) return std::string_view(small, length);
+    return interned().text;
+}
+
+const InternedText& String::interned() const {
+    if (kind == Kind::INTERNED) return *text;
+    std::call_once(flatten_once, [this]() {
+        std::string out;
+        out.reserve(length);
+        append_to(out);
+        text = intern_text(std::move(out));
+        flat.store(true, std::memory_order_release);
+        left.store(nullptr);
+        right.store(nullptr);
+    });
+    return *text;
+}
+
+// Solo se llama desde el armado de this, así que las partes de this siguen
+// ahí. Las de una rope interior las puede soltar otro hilo que la arma a la
+// vez: se toman con una referencia propia y, si ya no están, el texto armado
+// sí (se publica antes de soltarlas).
+void String::append_to(std::string& out) const {
+    std::vector<std::shared_ptr<const String>> pending{right.load(), left.load()};
+    while (!pending.empty()) {
+        std::shared_ptr<const String> node = std::move(pending.back());
+        pending.pop_back();
+        if (node->kind == Kind::SMALL) {
+            out.append(node->small, node->length);
+            continue;
+        }
+        if (node->kind == Kind::ROPE && !node->flat.load(std::memory_order_acquire)) {
+            auto node_left = node->left.load();
+            auto node_right = node->right.load();
+            if (node_left && node_right) {
+                pending.push_back(std::move(node_right));
+                pending.push_back(std::move(node_left));
+                continue;
+            }
+        }
+        out += node->text->text;
+    }
+}
+
+bool String::equals(const String& other) const {
+    if (this == &other) return true;
+    if (length != other.length) return false;
+    // Con el mismo largo las dos son cortas o las dos largas
+    if (kind == Kind::SMALL) return std::memcmp(small, other.small, length) == 0;
+    return &interned() == &other.interned();
+}
+
+int String::compare(const String& other) const {
+    return view().compare(other.view());
+}
+
+std::shared_ptr<String> make_string(std::string_view text) {
+    return std::make_shared<String>(text);
+}
+
+std::shared_ptr<String> concat_strings(const std::shared_ptr<String>& left, const std::shared_ptr<String>& right) {
+    if (right->size() == 0) return left;
+    if (left->size() == 0) return right;
+    size_t total = left->size() + right->size();
+    if (total <= String::SMALL_STRING) {
+        char buffer[String::SMALL_STRING];
+        std::string_view left_text = left->view();
+        std::memcpy(buffer, left_text.data(), left_text.size());
+        std::memcpy(buffer + left_text.size(), right->view().data(), right->size());
+        return make_string(std::string_view(buffer, total));
+    }
+    return std::make_shared<String>(left, right);
+}
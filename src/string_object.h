@@ -0,0 +1,74 @@
+#ifndef STRING_OBJECT_H
+#define STRING_OBJECT_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "object.h"
+
+// Texto de una cadena larga, único por contenido (ver intern_text)
+struct InternedText {
+    std::string text;
+};
+
+// El InternedText con ese contenido, creado si no existe. La tabla es global
+// y se puede usar desde varios hilos; una entrada se borra cuando la suelta
+// la última cadena que la usa.
+std::shared_ptr<const InternedText> intern_text(std::string text);
+
+// Cadena del lenguaje, inmutable. Según el largo:
+//  - hasta SMALL_STRING bytes el texto va dentro del objeto, sin otra reserva
+//  - las más largas apuntan a su InternedText: dos cadenas largas iguales
+//    comparten el mismo, así que compararlas es comparar punteros
+//  - una concatenación larga es una rope: guarda las dos partes y el texto
+//    se arma (y se interna) recién la primera vez que hace falta, recorriendo
+//    el árbol sin recursión. Así s = s + x en un ciclo no copia s cada vez.
+//    Ya armada suelta las partes: si no, cada rope intermedia armada
+//    retendría su propio texto completo.
+//
+// El armado corre una sola vez aunque lo pidan varios hilos, y las partes se
+// leen y se sueltan con operaciones atómicas, así que una cadena se puede
+// compartir entre tareas (ver HeapCopy) o desde el preludio del servidor.
+class String : public Object {
+public:
+    static constexpr size_t SMALL_STRING = 15;
+
+    // Usar make_string y concat_strings
+    explicit String(std::string_view text);
+    String(std::shared_ptr<String> left, std::shared_ptr<String> right);
+    ~String() override;
+
+    ObjectType type() const override { return ObjectType::STRING_OBJ; }
+    std::string inspect() const override { return std::string(view()); }
+
+    size_t size() const { return length; }
+    // Arma la rope si hace falta; vale mientras viva la cadena
+    std::string_view view() const;
+    bool equals(const String& other) const;
+    // Orden de bytes, como std::string_view::compare
+    int compare(const String& other) const;
+
+private:
+    enum class Kind : unsigned char { SMALL, INTERNED, ROPE };
+
+    Kind kind;
+    char small[SMALL_STRING];
+    size_t length;
+    // INTERNED; en una ROPE, el texto ya armado (cuando flat es true)
+    mutable std::shared_ptr<const InternedText> text;
+    // ROPE sin armar; vacías desde que flat es true
+    mutable std::atomic<std::shared_ptr<String>> left;
+    mutable std::atomic<std::shared_ptr<String>> right;
+    mutable std::once_flag flatten_once;
+    mutable std::atomic<bool> flat{false};
+
+    const InternedText& interned() const;
+    void append_to(std::string& out) const;
+};
+
+std::shared_ptr<String> make_string(std::string_view text);
+std::shared_ptr<String> concat_strings(const std::shared_ptr<String>& left, const std::shared_ptr<String>& right);
+
+#endif // STRING_OBJECT_H
@@ -12,6 +12,7 @@ std::string token_type_to_string(TokenType type) {
         case TokenType::IDENT: return "IDENT";
         case TokenType::ILLEGAL: return "ILLEGAL";
         case TokenType::INT: return "INT";
+        case TokenType::STRING: return "STRING";
         case TokenType::LBRACE: return "LBRACE";
         case TokenType::LET: return "LET";
         case TokenType::LPAREN: return "LPAREN";
@@ -32,6 +33,8 @@ std::string token_type_to_string(TokenType type) {
         case TokenType::ELSE: return "ELSE";
         case TokenType::RETURN: return "RETURN";
         case TokenType::WHILE: return "WHILE";
+        case TokenType::BREAK: return "BREAK";
+        case TokenType::CONTINUE: return "CONTINUE";
         default: return "UNKNOWN";
     }
 }
@@ -2,7 +2,9 @@
 #define TOKENS_H
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <array>
+#include <cstdint>
 #include <iostream>
 
 enum class TokenType {
@@ -12,6 +14,7 @@ enum class TokenType {
     // Identifiers + literals
     IDENT,
     INT,
+    STRING,
 
     // Operators
     ASSIGN,
@@ -44,8 +47,17 @@ enum class TokenType {
     RETURN,
     FOR,
     WHILE,
+    BREAK,
+    CONTINUE,
 };
 
+inline constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::CONTINUE) + 1;
+
+// Índice para las tablas indexadas por tipo de token
+constexpr size_t token_index(TokenType type) {
+    return static_cast<size_t>(type);
+}
+
 // 🔁 Declaración de función global
 std::string token_type_to_string(TokenType type);
 
@@ -53,18 +65,33 @@ class Token {
 public:
     TokenType token_type;
     std::string literal;
+    // Posición en el fuente, desde 1 (0 si no se conoce)
+    uint32_t line = 0;
+    uint32_t column = 0;
 
     Token() = default;
-    Token(TokenType type, const std::string& lit)
-        : token_type(type), literal(lit) {}
+    Token(TokenType type, const std::string& lit, uint32_t ln = 0, uint32_t col = 0)
+        : token_type(type), literal(lit), line(ln), column(col) {}
 
     std::string to_string() const {
         return "Token(" + token_type_to_string(token_type) + ", " + literal + ")";
     }
 };
 
-inline TokenType lookup_token_type(const std::string& literal) {
-    static std::unordered_map<std::string, TokenType> keywords = {
+struct KeywordEntry {
+    std::string_view text;
+    TokenType type = TokenType::IDENT;
+};
+
+// Hash perfecto para las palabras clave: con los dos primeros caracteres
+// alcanza para separar todas en una tabla de 16 posiciones.
+constexpr size_t keyword_hash(std::string_view s) {
+    return (5u * static_cast<unsigned char>(s[0]) + 2u * static_cast<unsigned char>(s[1])) & 15u;
+}
+
+inline constexpr auto keyword_table = [] {
+    std::array<KeywordEntry, 16> table{};
+    const KeywordEntry keywords[] = {
         {"fn", TokenType::FUNCTION},
         {"let", TokenType::LET},
         {"true", TokenType::TRUE},
@@ -74,13 +101,23 @@ inline TokenType lookup_token_type(const std::string& literal) {
         {"return", TokenType::RETURN},
         {"for", TokenType::FOR},
         {"while", TokenType::WHILE},
+        {"break", TokenType::BREAK},
+        {"continue", TokenType::CONTINUE},
     };
+    for (const auto& kw : keywords) {
+        auto& slot = table[keyword_hash(kw.text)];
+        if (!slot.text.empty()) throw "colision en keyword_hash"; // error en compilación
+        slot = kw;
+    }
+    return table;
+}();
 
-    auto it = keywords.find(literal);
-    if (it != keywords.end()) {
-        return it->second;
+inline TokenType lookup_token_type(std::string_view literal) {
+    if (literal.size() < 2) {
+        return TokenType::IDENT;
     }
-    return TokenType::IDENT;
+    const auto& entry = keyword_table[keyword_hash(literal)];
+    return entry.text == literal ? entry.type : TokenType::IDENT;
 }
 
 #endif // TOKENS_H
\ No newline at end of file
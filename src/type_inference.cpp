@@ -0,0 +1,450 @@
+#include "type_inference.h"
+#include <unordered_set>
+#include "builtins.h"
+
+using namespace static_types;
+
+namespace {
+
+unsigned char runtime_type(const Object& value) {
+    switch (value.type()) {
+        case ObjectType::INTEGER_OBJ: return INTEGER;
+        case ObjectType::BOOLEAN_OBJ: return BOOLEAN;
+        case ObjectType::FUNCTION_OBJ:
+        case ObjectType::BUILTIN_OBJ: return FUNCTION;
+        case ObjectType::NULL_OBJ: return NULL_VALUE;
+        case ObjectType::TASK_OBJ: return TASK;
+        case ObjectType::STRING_OBJ: return STRING;
+    }
+    return ANY;
+}
+
+// Un solo tipo posible: sirve para afirmar que una operación falla seguro
+bool is_single(unsigned char type) {
+    return type == INTEGER || type == BOOLEAN || type == FUNCTION || type == NULL_VALUE || type == TASK ||
+           type == STRING;
+}
+
+// Literales: nunca dan nullptr, así que un let con ellos siempre liga
+bool cannot_fail(const Expression* value) {
+    return dynamic_cast<const IntegerLiteral*>(value) || dynamic_cast<const BooleanLiteral*>(value) ||
+           dynamic_cast<const StringLiteral*>(value) || dynamic_cast<const FunctionLiteral*>(value);
+}
+
+// Nombres asignados dentro de funciones anidadas en node
+void collect_closure_assignments(const Node* node, bool nested, std::unordered_set<std::string>& out) {
+    if (!node) return;
+    if (auto func = dynamic_cast<const FunctionLiteral*>(node)) {
+        collect_closure_assignments(func->body.get(), true, out);
+    } else if (auto assign = dynamic_cast<const AssignExpression*>(node)) {
+        if (nested) out.insert(assign->name);
+        collect_closure_assignments(assign->value.get(), nested, out);
+    } else if (auto block = dynamic_cast<const BlockStatement*>(node)) {
+        for (const auto& stmt : block->statements) collect_closure_assignments(stmt.get(), nested, out);
+    } else if (auto stmt = dynamic_cast<const ExpressionStatement*>(node)) {
+        collect_closure_assignments(stmt->expression.get(), nested, out);
+    } else if (auto let_stmt = dynamic_cast<const LetStatement*>(node)) {
+        collect_closure_assignments(let_stmt->value.get(), nested, out);
+    } else if (auto return_stmt = dynamic_cast<const ReturnStatement*>(node)) {
+        collect_closure_assignments(return_stmt->value.get(), nested, out);
+    } else if (auto while_stmt = dynamic_cast<const WhileStatement*>(node)) {
+        collect_closure_assignments(while_stmt->condition.get(), nested, out);
+        collect_closure_assignments(while_stmt->body.get(), nested, out);
+    } else if (auto for_stmt = dynamic_cast<const ForStatement*>(node)) {
+        collect_closure_assignments(for_stmt->init.get(), nested, out);
+        collect_closure_assignments(for_stmt->condition.get(), nested, out);
+        collect_closure_assignments(for_stmt->update.get(), nested, out);
+        collect_closure_assignments(for_stmt->body.get(), nested, out);
+    } else if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        collect_closure_assignments(prefix->right.get(), nested, out);
+    } else if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        collect_closure_assignments(infix->left.get(), nested, out);
+        collect_closure_assignments(infix->right.get(), nested, out);
+    } else if (auto if_expr = dynamic_cast<const IfExpression*>(node)) {
+        collect_closure_assignments(if_expr->condition.get(), nested, out);
+        collect_closure_assignments(if_expr->consequence.get(), nested, out);
+        collect_closure_assignments(if_expr->alternative.get(), nested, out);
+    } else if (auto call = dynamic_cast<const CallExpression*>(node)) {
+        collect_closure_assignments(call->function.get(), nested, out);
+        for (const auto& arg : call->arguments) collect_closure_assignments(arg.get(), nested, out);
+    }
+}
+
+using TypeMap = std::unordered_map<std::string, unsigned char>;
+
+// Tipos de las variables en un punto del programa. Las copias comparten base
+// y solo duplican delta (lo ligado después de copiar): así copiar el estado en
+// cada ciclo o if no cuesta O(variables) en un programa con miles de globales
+struct TypeState {
+    bool reachable = true;
+    bool globals_unknown = false;   // hubo una llamada en el nivel superior
+    std::shared_ptr<TypeMap> base;
+    TypeMap delta;
+
+    const unsigned char* find(const std::string& name) const {
+        auto it = delta.find(name);
+        if (it != delta.end()) return &it->second;
+        if (!base) return nullptr;
+        auto base_it = base->find(name);
+        return base_it != base->end() ? &base_it->second : nullptr;
+    }
+
+    void set(const std::string& name, unsigned char type) { delta[name] = type; }
+
+    // Vuelca delta en base: en el lugar si nadie más la comparte, o copiándola
+    // cuando delta ya es tan grande como ella (costo amortizado constante)
+    void commit() {
+        if (delta.empty()) return;
+        if (!base) {
+            base = std::make_shared<TypeMap>(std::move(delta));
+        } else if (base.use_count() == 1 || delta.size() >= base->size()) {
+            if (base.use_count() != 1) base = std::make_shared<TypeMap>(*base);
+            for (auto& [name, type] : delta) (*base)[name] = type;
+        } else {
+            return;
+        }
+        delta.clear();
+    }
+
+    // Todas las variables pasan a ANY: con globals_unknown, no estar ligada equivale a ANY
+    void forget_all() {
+        globals_unknown = true;
+        base.reset();
+        delta.clear();
+    }
+
+    TypeMap flatten() const {
+        TypeMap vars = base ? *base : TypeMap{};
+        for (const auto& [name, type] : delta) vars[name] = type;
+        return vars;
+    }
+
+    bool operator==(const TypeState& other) const {
+        if (reachable != other.reachable || globals_unknown != other.globals_unknown) return false;
+        if (base != other.base) return flatten() == other.flatten();
+        auto same = [&](const TypeMap& keys) {
+            for (const auto& entry : keys) {
+                const unsigned char* mine = find(entry.first);
+                const unsigned char* theirs = other.find(entry.first);
+                if (!mine || !theirs ? mine != theirs : *mine != *theirs) return false;
+            }
+            return true;
+        };
+        return same(delta) && same(other.delta);
+    }
+};
+
+TypeState unreachable_state() {
+    TypeState state;
+    state.reachable = false;
+    return state;
+}
+
+class TypeInference {
+public:
+    explicit TypeInference(std::shared_ptr<Environment> env) : globals(std::move(env)) {}
+
+    std::vector<std::string> errors;
+
+    void run(Node* node) {
+        scopes.push_back(Scope{true, {}, {}});
+        TypeState state;
+        statement(node, state);
+        scopes.pop_back();
+    }
+
+    // Un cuerpo suelto: los parámetros, como las variables libres, quedan
+    // desconocidos al no estar en el estado
+    void run_function_body(BlockStatement* body) {
+        Scope scope{false, {}, {}};
+        collect_closure_assignments(body, false, scope.closure_assigned);
+        scopes.push_back(std::move(scope));
+        TypeState state;
+        statement(body, state);
+        scopes.pop_back();
+    }
+
+private:
+    // Una vuelta de un ciclo: estados que llegan a un break o a un continue
+    struct LoopExits {
+        TypeState breaks = unreachable_state();
+        TypeState continues = unreachable_state();
+    };
+
+    // El nivel superior o el cuerpo de una función
+    struct Scope {
+        bool top_level;
+        std::unordered_set<std::string> closure_assigned;
+        std::vector<LoopExits> loops;
+    };
+
+    static constexpr int MAX_LOOP_PASSES = 16;
+
+    std::shared_ptr<Environment> globals;
+    std::vector<Scope> scopes;
+    std::unordered_set<const Node*> reported;
+
+    void report(const Node* node, const std::string& message) {
+        if (reported.insert(node).second) {
+            std::string where = node->line ? " (" + std::to_string(node->line) + ":" + std::to_string(node->column) + ")" : "";
+            errors.push_back("Error de tipos" + where + ": " + message + " en " + node->to_string());
+        }
+    }
+
+    unsigned char lookup(const TypeState& state, const std::string& name) const {
+        if (const unsigned char* type = state.find(name)) return *type;
+        // Dentro de una función: parámetro desconocido o variable libre
+        if (!scopes.back().top_level || state.globals_unknown) return ANY;
+        if (auto value = globals ? globals->get(name) : nullptr) return runtime_type(*value);
+        if (lookup_builtin(name)) return FUNCTION;
+        return NONE;   // sin ligar: leerla da un error (nullptr)
+    }
+
+    TypeState join(const TypeState& a, const TypeState& b) const {
+        if (!a.reachable) return b;
+        if (!b.reachable) return a;
+        TypeState result;
+        result.globals_unknown = a.globals_unknown || b.globals_unknown;
+        if (a.base == b.base) {
+            // Misma base: solo difiere lo ligado en cada rama
+            result.base = a.base;
+            for (const auto& [name, type] : a.delta) result.delta[name] = type | lookup(b, name);
+            for (const auto& [name, type] : b.delta) result.delta[name] = type | lookup(a, name);
+            return result;
+        }
+        // Con globales desconocidas lo que falta en ese lado ya es ANY en el resultado
+        auto add = [&](const TypeState& side, const TypeState& other) {
+            for (const auto& [name, type] : side.flatten()) result.delta[name] = type | lookup(other, name);
+        };
+        if (a.globals_unknown) {
+            add(a, b);
+        } else if (b.globals_unknown) {
+            add(b, a);
+        } else {
+            add(a, b);
+            add(b, a);
+        }
+        result.commit();
+        return result;
+    }
+
+    // Una llamada puede correr cualquier clausura: en el nivel superior
+    // todas pueden asignar globales, en una función solo las creadas en ella
+    void kill_after_call(TypeState& state) const {
+        const Scope& scope = scopes.back();
+        if (scope.top_level) {
+            state.forget_all();
+            return;
+        }
+        for (const auto& name : scope.closure_assigned) {
+            if (state.find(name)) state.set(name, ANY);
+        }
+    }
+
+    // let o asignación: si el valor falla la variable conserva el anterior
+    void bind(TypeState& state, const std::string& name, unsigned char type, const Expression* value) {
+        state.set(name, cannot_fail(value) ? type : type | lookup(state, name));
+    }
+
+    unsigned char statement(Node* node, TypeState& state) {
+        if (!node || !state.reachable) return NONE;
+
+        if (auto program = dynamic_cast<Program*>(node)) {
+            unsigned char type = NONE;
+            for (auto& stmt : program->statements) {
+                type = statement(stmt.get(), state);
+                state.commit();
+            }
+            return type;
+        }
+        if (auto block = dynamic_cast<BlockStatement*>(node)) {
+            unsigned char type = NONE;
+            for (auto& stmt : block->statements) {
+                type = statement(stmt.get(), state);
+                state.commit();
+            }
+            return type;
+        }
+        if (auto stmt = dynamic_cast<ExpressionStatement*>(node)) {
+            return expression(stmt->expression.get(), state);
+        }
+        if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
+            unsigned char type = expression(let_stmt->value.get(), state);
+            bind(state, let_stmt->name, type, let_stmt->value.get());
+            return type;
+        }
+        if (auto return_stmt = dynamic_cast<ReturnStatement*>(node)) {
+            expression(return_stmt->value.get(), state);
+            state.reachable = false;
+            return NONE;
+        }
+        if (dynamic_cast<BreakStatement*>(node) || dynamic_cast<ContinueStatement*>(node)) {
+            auto& loops = scopes.back().loops;
+            if (!loops.empty()) {
+                TypeState& target = dynamic_cast<BreakStatement*>(node) ? loops.back().breaks : loops.back().continues;
+                target = join(target, state);
+            }
+            state.reachable = false;
+            return NONE;
+        }
+        if (auto while_stmt = dynamic_cast<WhileStatement*>(node)) {
+            loop(while_stmt->condition.get(), while_stmt->body.get(), nullptr, state);
+            return ANY;
+        }
+        if (auto for_stmt = dynamic_cast<ForStatement*>(node)) {
+            statement(for_stmt->init.get(), state);
+            loop(for_stmt->condition.get(), for_stmt->body.get(), for_stmt->update.get(), state);
+            return ANY;
+        }
+        return ANY;
+    }
+
+    // Punto fijo sobre la cabecera del ciclo: se repite hasta que los tipos
+    // al volver a la condición no agregan nada nuevo
+    void loop(Expression* condition, BlockStatement* body, Statement* update, TypeState& state) {
+        // Sin referencias a scopes.back(): una función en el cuerpo apila otro Scope
+        TypeState head = state;
+        TypeState exit;
+        for (int pass = 0;; ++pass) {
+            scopes.back().loops.push_back(LoopExits{});
+            TypeState current = head;
+            if (condition) expression(condition, current);
+            TypeState after_condition = condition ? current : unreachable_state();
+            statement(body, current);
+            current = join(current, scopes.back().loops.back().continues);
+            statement(update, current);
+            exit = join(after_condition, scopes.back().loops.back().breaks);
+            scopes.back().loops.pop_back();
+
+            TypeState next = join(head, current);
+            if (next == head) break;
+            head = std::move(next);
+            if (pass == MAX_LOOP_PASSES) {
+                // No debería pasar (el reticulado es finito): se abandona la precisión
+                head.forget_all();
+            }
+        }
+        state = std::move(exit);
+    }
+
+    void function(FunctionLiteral* func) {
+        Scope scope{false, {}, {}};
+        collect_closure_assignments(func->body.get(), false, scope.closure_assigned);
+        scopes.push_back(std::move(scope));
+        TypeState state;
+        for (const auto& param : func->parameters) state.set(param, ANY);
+        statement(func->body.get(), state);
+        scopes.pop_back();
+    }
+
+    unsigned char expression(Expression* node, TypeState& state) {
+        if (!node) return NONE;
+        unsigned char type = infer(node, state);
+        node->static_type = type;
+        return type;
+    }
+
+    unsigned char infer(Expression* node, TypeState& state) {
+        if (dynamic_cast<IntegerLiteral*>(node)) return INTEGER;
+        if (dynamic_cast<BooleanLiteral*>(node)) return BOOLEAN;
+        if (dynamic_cast<StringLiteral*>(node)) return STRING;
+
+        if (auto ident = dynamic_cast<Identifier*>(node)) {
+            return lookup(state, ident->value);
+        }
+
+        if (auto func = dynamic_cast<FunctionLiteral*>(node)) {
+            function(func);
+            return FUNCTION;
+        }
+
+        if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+            unsigned char right = expression(prefix->right.get(), state);
+            if (prefix->op == "!") return BOOLEAN;
+            if (is_single(right) && right != INTEGER) {
+                report(node, "'-' sobre " + static_type_to_string(right));
+            }
+            return INTEGER;
+        }
+
+        if (auto infix = dynamic_cast<InfixExpression*>(node)) {
+            unsigned char left = expression(infix->left.get(), state);
+            unsigned char right = expression(infix->right.get(), state);
+            bool equality = infix->op == "==" || infix->op == "!=";
+            bool concatenation = infix->op == "+";
+            bool ordering = infix->op == "<" || infix->op == ">";
+            bool valid = (left == INTEGER && right == INTEGER) ||
+                         (equality && left == BOOLEAN && right == BOOLEAN) ||
+                         ((equality || concatenation || ordering) && left == STRING && right == STRING);
+            if (is_single(left) && is_single(right) && !valid) {
+                report(node, "'" + infix->op + "' entre " + static_type_to_string(left) + " y " +
+                                 static_type_to_string(right));
+            }
+            // + suma enteros o concatena cadenas
+            if (concatenation && (left & right & STRING)) {
+                return (left & right & INTEGER) | STRING;
+            }
+            bool arithmetic = concatenation || infix->op == "-" || infix->op == "*" || infix->op == "/";
+            return arithmetic ? INTEGER : BOOLEAN;
+        }
+
+        if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
+            expression(if_expr->condition.get(), state);
+            TypeState else_state = state;
+            unsigned char type = statement(if_expr->consequence.get(), state);
+            type |= if_expr->alternative ? statement(if_expr->alternative.get(), else_state) : NULL_VALUE;
+            state = join(state, else_state);
+            return type;
+        }
+
+        if (auto assign = dynamic_cast<AssignExpression*>(node)) {
+            unsigned char type = expression(assign->value.get(), state);
+            // Una variable libre puede cambiar por otras vías: queda desconocida
+            if (scopes.back().top_level || state.find(assign->name)) {
+                bind(state, assign->name, type, assign->value.get());
+            }
+            return type;
+        }
+
+        if (auto call = dynamic_cast<CallExpression*>(node)) {
+            unsigned char callee = expression(call->function.get(), state);
+            for (auto& arg : call->arguments) expression(arg.get(), state);
+            if (is_single(callee) && callee != FUNCTION) {
+                report(node, "llamada a un valor " + static_type_to_string(callee));
+            }
+            kill_after_call(state);
+            return ANY;
+        }
+
+        return ANY;
+    }
+};
+
+} // namespace
+
+std::vector<std::string> infer_types(Node* node, const std::shared_ptr<Environment>& env) {
+    TypeInference inference(env);
+    inference.run(node);
+    return std::move(inference.errors);
+}
+
+std::vector<std::string> infer_function_body_types(BlockStatement* body) {
+    TypeInference inference(nullptr);
+    inference.run_function_body(body);
+    return std::move(inference.errors);
+}
+
+std::string static_type_to_string(unsigned char type) {
+    if (type == ANY) return "ANY";
+    if (type == NONE) return "NONE";
+    std::string result;
+    const std::pair<unsigned char, const char*> names[] = {
+        {INTEGER, "INTEGER"}, {BOOLEAN, "BOOLEAN"}, {FUNCTION, "FUNCTION"}, {NULL_VALUE, "NULL"}, {TASK, "TASK"}, {STRING, "STRING"},
+    };
+    for (const auto& [bit, name] : names) {
+        if (!(type & bit)) continue;
+        if (!result.empty()) result += "|";
+        result += name;
+    }
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef TYPE_INFERENCE_H
+#define TYPE_INFERENCE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "environment.h"
+
+// Inferencia de tipos sobre el AST, antes de evaluar. Marca static_type en
+// cada expresión para que el evaluador salte los chequeos de tipo donde los
+// operandos ya están probados (ver eval_infix_expression en evaluator.h), y
+// devuelve los errores de tipo seguros: operaciones que fallan con
+// cualquier valor que puedan tomar sus operandos.
+//
+// Es sensible al flujo: let y las asignaciones cambian el tipo de una
+// variable, los if y los ciclos unen los tipos de cada camino. Las variables
+// de nivel superior parten del tipo de su valor actual en env; una llamada
+// puede correr una clausura que las asigne, así que después de cada llamada
+// se vuelven desconocidas. Los cuerpos de función se analizan sin contexto
+// (parámetros y variables libres desconocidos), así sus marcas valen para
+// cualquier llamada.
+std::vector<std::string> infer_types(Node* node, const std::shared_ptr<Environment>& env);
+
+// Lo mismo para el cuerpo de una función parseado aparte (ver LazyBody)
+std::vector<std::string> infer_function_body_types(BlockStatement* body);
+
+std::string static_type_to_string(unsigned char type);
+
+#endif // TYPE_INFERENCE_H
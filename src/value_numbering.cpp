@@ -0,0 +1,251 @@
+#include "value_numbering.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Menos nodos que esto (una variable negada, por ejemplo) no vale la ranura
+constexpr size_t MIN_NODES = 3;
+
+// Una subexpresión candidata, en preorden: las que están dentro de ella son
+// las de índice menor que end
+struct Occurrence {
+    Node* node;
+    uint32_t number = 0;   // número de valor
+    uint32_t nodes = 0;
+    size_t end = 0;
+    bool removed = false;  // dentro de una repetición: no se evalúa
+};
+
+// Operación con los números de valor de sus operandos (right sin usar en los prefijos)
+struct OperationKey {
+    const std::string* op;
+    bool prefix;
+    uint32_t left;
+    uint32_t right;
+
+    bool operator==(const OperationKey& other) const {
+        return *op == *other.op && prefix == other.prefix && left == other.left && right == other.right;
+    }
+};
+
+struct OperationKeyHash {
+    size_t operator()(const OperationKey& key) const {
+        size_t hash = std::hash<std::string>()(*key.op) ^ key.prefix;
+        hash = hash * 31 + key.left;
+        return hash * 31 + key.right;
+    }
+};
+
+// Huella de la forma de node, sin mirar versiones; false si node no es puro
+// (solo literales, variables y operadores). Agrega a shapes las de las
+// subexpresiones candidatas: si en una racha ninguna forma se repite no hay
+// nada que numerar, y la mayoría de los bloques se descartan sin armar tablas.
+bool collect_shapes(const Expression* node, size_t& shape, uint32_t& nodes, std::vector<size_t>& shapes) {
+    nodes = 1;
+    if (auto ident = dynamic_cast<const Identifier*>(node)) {
+        shape = std::hash<std::string>()(ident->value);
+        return true;
+    }
+    if (auto int_lit = dynamic_cast<const IntegerLiteral*>(node)) {
+        shape = std::hash<int>()(int_lit->value) * 7 + 1;
+        return true;
+    }
+    if (auto bool_lit = dynamic_cast<const BooleanLiteral*>(node)) {
+        shape = bool_lit->value ? 2 : 3;
+        return true;
+    }
+    size_t left = 0, right = 0;
+    uint32_t left_nodes = 0, right_nodes = 0;
+    const std::string* op;
+    if (auto prefix = dynamic_cast<const PrefixExpression*>(node)) {
+        op = &prefix->op;
+        if (!collect_shapes(prefix->right.get(), right, right_nodes, shapes)) return false;
+    } else if (auto infix = dynamic_cast<const InfixExpression*>(node)) {
+        op = &infix->op;
+        if (!collect_shapes(infix->left.get(), left, left_nodes, shapes) ||
+            !collect_shapes(infix->right.get(), right, right_nodes, shapes)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    nodes += left_nodes + right_nodes;
+    shape = ((std::hash<std::string>()(*op) * 31 + left) * 31 + right) * 31 + nodes;
+    if (nodes >= MIN_NODES) shapes.push_back(shape);
+    return true;
+}
+
+bool is_pure(const Expression* node, std::vector<size_t>& shapes) {
+    size_t mark = shapes.size();
+    size_t shape;
+    uint32_t nodes;
+    if (collect_shapes(node, shape, nodes, shapes)) return true;
+    shapes.resize(mark);
+    return false;
+}
+
+// Sentencia que puede formar parte de una racha: value es lo que evalúa
+// (nullptr si nada que numerar) y target lo que liga o asigna
+bool pure_statement(Statement* stmt, Expression*& value, std::string& target, std::vector<size_t>& shapes) {
+    value = nullptr;
+    target.clear();
+    if (auto let_stmt = dynamic_cast<LetStatement*>(stmt)) {
+        target = let_stmt->name;
+        // Crear una clausura no corre código
+        if (dynamic_cast<FunctionLiteral*>(let_stmt->value.get())) return true;
+        value = let_stmt->value.get();
+        return is_pure(value, shapes);
+    }
+    if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(stmt)) {
+        if (auto assign = dynamic_cast<AssignExpression*>(expr_stmt->expression.get())) {
+            target = assign->name;
+            value = assign->value.get();
+        } else {
+            value = expr_stmt->expression.get();
+        }
+        return value && is_pure(value, shapes);
+    }
+    if (auto return_stmt = dynamic_cast<ReturnStatement*>(stmt)) {
+        value = return_stmt->value.get();
+        return !value || is_pure(value, shapes);
+    }
+    return false;
+}
+
+class RunNumbering {
+public:
+    void add(Expression* value, const std::string& target) {
+        if (value) number(value);
+        // Lo que venga después ve otro valor de target
+        if (!target.empty()) variables.erase(target);
+    }
+
+    void assign_roles() {
+        std::vector<std::vector<size_t>> by_number(next_number);
+        std::vector<size_t> firsts;
+        for (size_t i = 0; i < occurrences.size(); ++i) {
+            if (occurrences[i].nodes < MIN_NODES) continue;
+            auto& list = by_number[occurrences[i].number];
+            list.push_back(i);
+            if (list.size() == 2) firsts.push_back(list[0]);
+        }
+        // Las más grandes primero: sus repeticiones ocultan lo que tienen adentro
+        std::stable_sort(firsts.begin(), firsts.end(), [this](size_t a, size_t b) {
+            return occurrences[a].nodes > occurrences[b].nodes;
+        });
+
+        size_t next_slot = 0;
+        std::vector<size_t> live;
+        for (size_t first : firsts) {
+            live.clear();
+            for (size_t i : by_number[occurrences[first].number]) {
+                if (!occurrences[i].removed) live.push_back(i);
+            }
+            if (live.size() < 2) continue;
+            if (next_slot == VALUE_SLOTS) break;
+
+            auto slot = static_cast<uint8_t>(next_slot++);
+            for (size_t n = 0; n < live.size(); ++n) {
+                Occurrence& occurrence = occurrences[live[n]];
+                occurrence.node->value_slot = slot;
+                if (n == 0) {
+                    occurrence.node->value_role = ValueRole::DEFINE;
+                    continue;
+                }
+                occurrence.node->value_role = n + 1 == live.size() ? ValueRole::LAST_REUSE : ValueRole::REUSE;
+                for (size_t inside = live[n] + 1; inside < occurrence.end; ++inside) {
+                    occurrences[inside].removed = true;
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<Occurrence> occurrences;
+    uint32_t next_number = 0;
+    // Valor actual de cada variable: un let o una asignación le da uno nuevo
+    std::unordered_map<std::string, uint32_t> variables;
+    std::unordered_map<int, uint32_t> integers;
+    std::unordered_map<OperationKey, uint32_t, OperationKeyHash> operations;
+
+    uint32_t fresh() { return next_number++; }
+
+    uint32_t number(Expression* node, uint32_t* nodes = nullptr) {
+        node->value_role = ValueRole::NONE;
+        uint32_t count = 1;
+        uint32_t value;
+        if (auto ident = dynamic_cast<Identifier*>(node)) {
+            auto [it, inserted] = variables.try_emplace(ident->value, next_number);
+            if (inserted) fresh();
+            value = it->second;
+        } else if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
+            auto [it, inserted] = integers.try_emplace(int_lit->value, next_number);
+            if (inserted) fresh();
+            value = it->second;
+        } else if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
+            uint32_t& known = bool_lit->value ? true_number : false_number;
+            if (known == UNNUMBERED) known = fresh();
+            value = known;
+        } else {
+            size_t index = occurrences.size();
+            occurrences.push_back(Occurrence{node});
+            OperationKey key{};
+            if (auto prefix = dynamic_cast<PrefixExpression*>(node)) {
+                key = OperationKey{&prefix->op, true, number(prefix->right.get(), &count), 0};
+            } else {
+                auto infix = static_cast<InfixExpression*>(node);
+                uint32_t left = number(infix->left.get(), &count);
+                key = OperationKey{&infix->op, false, left, number(infix->right.get(), &count)};
+            }
+            auto [it, inserted] = operations.try_emplace(key, next_number);
+            if (inserted) fresh();
+            value = it->second;
+            Occurrence& occurrence = occurrences[index];
+            occurrence.number = value;
+            occurrence.nodes = count;
+            occurrence.end = occurrences.size();
+        }
+        if (nodes) *nodes += count;
+        return value;
+    }
+
+    static constexpr uint32_t UNNUMBERED = UINT32_MAX;
+    uint32_t true_number = UNNUMBERED;
+    uint32_t false_number = UNNUMBERED;
+};
+
+} // namespace
+
+void number_values(std::span<const std::unique_ptr<Statement>> statements) {
+    // Racha actual: lo que evalúa cada sentencia, lo que liga y las formas
+    std::vector<Expression*> values;
+    std::vector<std::string> targets;
+    std::vector<size_t> shapes;
+    auto close_run = [&]() {
+        std::sort(shapes.begin(), shapes.end());
+        if (std::adjacent_find(shapes.begin(), shapes.end()) != shapes.end()) {
+            RunNumbering run;
+            for (size_t i = 0; i < values.size(); ++i) run.add(values[i], targets[i]);
+            run.assign_roles();
+        }
+        values.clear();
+        targets.clear();
+        shapes.clear();
+    };
+    for (const auto& stmt : statements) {
+        Expression* value;
+        std::string target;
+        if (!stmt || !pure_statement(stmt.get(), value, target, shapes)) {
+            close_run();
+            continue;
+        }
+        values.push_back(value);
+        targets.push_back(std::move(target));
+        if (dynamic_cast<ReturnStatement*>(stmt.get())) close_run();
+    }
+    close_run();
+}
@@ -0,0 +1,50 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include <array>
+#include <memory>
+#include <span>
+#include "ast.h"
+#include "object.h"
+
+// Numeración de valores: en una racha de sentencias puras de un bloque
+// (let, asignaciones y expresiones sin llamadas), una subexpresión repetida
+// sobre las mismas ligaduras se calcula solo la primera vez. Por ejemplo, en
+// (a * b) + (a * b) - c la segunda a * b usa el valor de la primera.
+//
+// El árbol no cambia: solo se marcan los nodos (ValueRole), así que quien no
+// conoce la marca (el nivel de loops, la aritmética sin objetos) simplemente
+// recalcula. Como en la racha no hay llamadas, entre la primera aparición y
+// las repeticiones no corre otro código y los valores pueden vivir en
+// ranuras por hilo.
+void number_values(std::span<const std::unique_ptr<Statement>> statements);
+
+inline constexpr size_t VALUE_SLOTS = 64;
+
+inline thread_local std::array<std::shared_ptr<Object>, VALUE_SLOTS> numbered_values;
+
+// Para los evaluadores: true si node es una repetición con el valor ya
+// calculado. Si la primera aparición falló se recalcula, y vuelve a fallar
+// con los mismos mensajes.
+inline bool reuse_numbered_value(const Node* node, std::shared_ptr<Object>& value) {
+    if (node->value_role != ValueRole::REUSE && node->value_role != ValueRole::LAST_REUSE) return false;
+    std::shared_ptr<Object>& saved = numbered_values[node->value_slot];
+    if (!saved) return false;
+    value = node->value_role == ValueRole::LAST_REUSE ? std::move(saved) : saved;
+    return true;
+}
+
+inline std::shared_ptr<Object> define_numbered_value(const Node* node, std::shared_ptr<Object> value) {
+    if (node->value_role == ValueRole::DEFINE) numbered_values[node->value_slot] = value;
+    return value;
+}
+
+// Para quien calcula sin pasar por los evaluadores: la ranura queda vacía y
+// las repeticiones recalculan
+inline void skip_numbered_value(const Node* node) {
+    if (node->value_role == ValueRole::DEFINE || node->value_role == ValueRole::LAST_REUSE) {
+        numbered_values[node->value_slot].reset();
+    }
+}
+
+#endif // VALUE_NUMBERING_H
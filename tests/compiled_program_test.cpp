@@ -0,0 +1,129 @@
+// Pruebas de CompiledProgram: varias ejecuciones de un mismo programa, en
+// serie y desde varios hilos, sobre un entorno global compartido
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "compiled_program.h"
+#include "evaluator.h"
+#include "parallel_parser.h"
+
+static std::atomic<int> failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FALLA: " << what << "\n";
+        ++failures;
+    }
+}
+
+static bool is_integer(const std::shared_ptr<Object>& value, int expected) {
+    return value && value->type() == ObjectType::INTEGER_OBJ && static_cast<Integer&>(*value).value == expected;
+}
+
+// Un entorno con source ya evaluado, como el de un preludio cargado
+static std::shared_ptr<Environment> globals_from(const std::string& source) {
+    std::vector<std::string> errors;
+    std::unique_ptr<Program> program = parse_source(source, errors);
+    auto env = std::make_shared<Environment>();
+    eval(program.get(), env);
+    return env;
+}
+
+// Una función global que asigna otra global no puede escribir en el entorno
+// compartido: cada ejecución falla igual y ninguna ve lo de las anteriores
+static void prelude_assignment_does_not_leak() {
+    auto globals = globals_from("let counter = 0; let inc = fn() { counter = counter + 1; counter };");
+    std::vector<std::string> errors;
+    auto program = CompiledProgram::compile("inc();", {}, errors, globals);
+    check(program != nullptr, "compila con globals");
+    if (!program) return;
+
+    // La asignación falla (se informa) y la función devuelve el counter de globals
+    check(is_integer(program->run({}), 0), "primera ejecución ve counter = 0");
+    check(is_integer(program->run({}), 0), "segunda ejecución también ve counter = 0");
+    check(is_integer(globals->get("counter"), 0), "counter sigue en 0 en globals");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&program]() {
+            for (int i = 0; i < 25; ++i) {
+                check(is_integer(program->run({}), 0), "una ejecución en paralelo ve counter = 0");
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    check(is_integer(globals->get("counter"), 0), "counter sigue en 0 después de ejecutar en paralelo");
+
+    // Asignar la global desde el propio programa escribe en su copia
+    auto own = CompiledProgram::compile("counter = counter + 1; counter;", {}, errors, globals);
+    check(own && is_integer(own->run({}), 1), "primera ejecución ve counter = 1");
+    check(own && is_integer(own->run({}), 1), "segunda ejecución también ve counter = 1");
+}
+
+// Se compila una vez y se ejecuta con entradas distintas: lo que liga una
+// ejecución no lo ve la siguiente
+static void compile_once_run_many() {
+    auto globals = globals_from("let twice = fn(n) { n * 2 };");
+    std::vector<std::string> errors;
+    auto program = CompiledProgram::compile("let total = twice(x) + y; if (flag) { total } else { 0 - total }",
+                                            {{"x", ObjectType::INTEGER_OBJ},
+                                             {"y", ObjectType::INTEGER_OBJ},
+                                             {"flag", ObjectType::BOOLEAN_OBJ}},
+                                            errors, globals);
+    check(program != nullptr, "compila con entradas");
+    if (!program) return;
+
+    for (int i = 0; i < 100; ++i) {
+        auto flag = std::make_shared<Boolean>(i % 2 == 0);
+        auto result = program->run({std::make_shared<Integer>(i), std::make_shared<Integer>(1), flag});
+        int expected = i % 2 == 0 ? i * 2 + 1 : -(i * 2 + 1);
+        check(is_integer(result, expected), "run " + std::to_string(i) + " da " + std::to_string(expected));
+    }
+    check(globals->get("total") == nullptr, "total no queda en globals");
+
+    check(program->run({std::make_shared<Integer>(1)}) == nullptr, "faltan entradas");
+    check(program->run({std::make_shared<Boolean>(true), std::make_shared<Integer>(1),
+                        std::make_shared<Boolean>(true)}) == nullptr, "entrada de otro tipo");
+
+    auto bad = CompiledProgram::compile("let = 1;", {}, errors);
+    check(bad == nullptr && !errors.empty(), "error de parsing en compile");
+}
+
+// run() desde varios hilos a la vez, cada uno con sus entradas
+static void run_from_many_threads() {
+    auto globals = globals_from("let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } };");
+    std::vector<std::string> errors;
+    auto program = CompiledProgram::compile("let r = fib(n); r + n;", {{"n", ObjectType::INTEGER_OBJ}},
+                                            errors, globals);
+    check(program != nullptr, "compila fib");
+    if (!program) return;
+
+    const int fibs[] = {0, 1, 1, 2, 3, 5, 8, 13, 21, 34, 55};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&program, &fibs, t]() {
+            for (int i = 0; i < 200; ++i) {
+                int n = (t + i) % 11;
+                auto result = program->run({std::make_shared<Integer>(n)});
+                check(is_integer(result, fibs[n] + n), "fib en paralelo");
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    check(globals->get("r") == nullptr, "r no queda en globals");
+}
+
+int main() {
+    prelude_assignment_does_not_leak();
+    compile_once_run_many();
+    run_from_many_threads();
+    if (failures) {
+        std::cerr << failures.load() << " pruebas fallaron\n";
+        return 1;
+    }
+    std::cout << "OK\n";
+    return 0;
+}